@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+#include "../src/game_controller.h"
+#include "../src/savefile.h"
+#include "../src/ui_controller.h"
+
+// Times the game engine entry points, save/load and a headless render() on
+// fixed seeds. Each result is the median of several batches of at least
+// BATCH_SECONDS of measured time, or BATCH_WALL_SECONDS in all when restoring
+// the board between operations is what takes the time. Results can be written
+// as "name<TAB>ns per op" lines and compared against a file in that format.
+
+struct Preset {
+  int rows, cols, mines;
+};
+
+struct Result {
+  std::string name;
+  double ns;
+};
+
+static const uint64_t SEED = 20240601;
+static const double BATCH_SECONDS = 0.02;
+static const double BATCH_WALL_SECONDS = 0.2;
+static const int BATCHES = 5;
+// Destructive benchmarks run on fresh copies of a board; at most this many
+// bytes of copies exist at once.
+static const size_t COPY_BYTES = 64 << 20;
+
+static std::vector<Result> results;
+static const char* filter = nullptr;
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+// Keeps the compiler from discarding a result that is never used.
+template <typename T>
+static void keep(const T& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+// `run(iterations)` returns the seconds its timed part took for that many
+// iterations, each of `opsPerIteration` operations.
+template <typename Run>
+static void bench(const char* function,
+                  const Preset& preset,
+                  Run run,
+                  double opsPerIteration = 1) {
+  char name[96];
+  snprintf(name, sizeof name, "%s/%dx%d/%d", function, preset.rows,
+           preset.cols, preset.mines);
+  if (filter && !strstr(name, filter))
+    return;
+
+  int iterations = 1;
+  while (iterations < 1 << 30) {
+    auto start = std::chrono::steady_clock::now();
+    double seconds = run(iterations);
+    double wall = secondsSince(start);
+    if (seconds >= BATCH_SECONDS || wall >= BATCH_WALL_SECONDS)
+      break;
+    double grow = std::min(100.0, 1.5 * BATCH_WALL_SECONDS / wall);
+    if (seconds > 0)
+      grow = std::min(grow, 1.5 * BATCH_SECONDS / seconds);
+    iterations = std::max(iterations + 1, (int)(iterations * grow));
+  }
+  double batches[BATCHES];
+  for (int i = 0; i < BATCHES; i++)
+    batches[i] = run(iterations);
+  std::sort(batches, batches + BATCHES);
+  double ns = batches[BATCHES / 2] / iterations / opsPerIteration * 1e9;
+  results.push_back({name, ns});
+  printf("%-44s %14.1f\n", name, ns);
+  fflush(stdout);
+}
+
+// Times `run` on `iterations` copies of `base` so that restoring the board
+// an operation consumed is not measured.
+template <typename Run>
+static double onCopies(const GameState& base, int iterations, Run run) {
+  size_t batch = std::max<size_t>(1, COPY_BYTES / (base.cells.size() + 64));
+  std::vector<GameState> copies;
+  double seconds = 0;
+  for (int done = 0; done < iterations;) {
+    int count = std::min<size_t>(iterations - done, batch);
+    copies.assign(count, base);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++)
+      run(copies[i], done + i);
+    seconds += secondsSince(start);
+    done += count;
+  }
+  return seconds;
+}
+
+// A generated board with every mine flagged and every numbered cell opened,
+// so that chording each numbered cell opens the rest of the board.
+static void chordBoard(const Preset& preset,
+                       GameState& state,
+                       std::vector<CellPos>& numbered) {
+  initBoard(state, preset.rows, preset.cols, preset.mines);
+  genBoard(state, 1, 1, SEED);
+  numbered.clear();
+  for (int r = 1; r <= state.rows; r++)
+    for (int c = 1; c <= state.cols; c++) {
+      unsigned char& cell = state.cells[cellIndex(state, r, c)];
+      if (cell & CELL_MINE) {
+        cell |= CELL_FLAG;
+        state.flagCount++;
+      } else if (cell & CELL_COUNT) {
+        cell |= CELL_OPENED;
+        state.openedCount++;
+        numbered.push_back({r, c});
+      }
+    }
+}
+
+static void engineBenchmarks(const Preset& preset) {
+  const int first_r = (preset.rows + 1) / 2, first_c = (preset.cols + 1) / 2;
+
+  bench("initBoard", preset, [&](int iterations) {
+    GameState state;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      initBoard(state, preset.rows, preset.cols, preset.mines);
+      keep(state.cells[0]);
+    }
+    return secondsSince(start);
+  });
+
+  GameState empty;
+  initBoard(empty, preset.rows, preset.cols, preset.mines);
+  bench("genBoard", preset, [&](int iterations) {
+    return onCopies(empty, iterations, [&](GameState& state, int i) {
+      genBoard(state, first_r, first_c, SEED + i);
+    });
+  });
+
+  GameState generated = empty;
+  genBoard(generated, first_r, first_c, SEED);
+  bench("openPosition.first", preset, [&](int iterations) {
+    return onCopies(generated, iterations, [&](GameState& state, int) {
+      openPosition(state, first_r, first_c);
+    });
+  });
+
+  GameState chord;
+  std::vector<CellPos> numbered;
+  chordBoard(preset, chord, numbered);
+  if (!numbered.empty())
+    bench(
+        "openPosition.chord", preset,
+        [&](int iterations) {
+          return onCopies(chord, iterations, [&](GameState& state, int) {
+            for (const CellPos& cell : numbered)
+              openPosition(state, cell.r, cell.c);
+          });
+        },
+        numbered.size());
+
+  bench("isWinState", preset, [&](int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      keep(chord);
+      bool won = isWinState(chord);
+      keep(won);
+    }
+    return secondsSince(start);
+  });
+
+  GameState lost = generated;
+  openPosition(lost, first_r, first_c);
+  bench("openAllBomb", preset, [&](int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      openAllBomb(lost);
+      keep(lost.cells[0]);
+    }
+    return secondsSince(start);
+  });
+
+  GameState saved = generated;
+  openPosition(saved, first_r, first_c);
+  std::vector<unsigned char> data;
+  bench("encodeSave", preset, [&](int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      encodeSave(saved, data);
+      keep(data[0]);
+    }
+    return secondsSince(start);
+  });
+
+  encodeSave(saved, data);
+  bench("decodeSave", preset, [&](int iterations) {
+    GameState state;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      if (!decodeSave(data.data(), data.size(), state))
+        abort();
+      keep(state.cells[0]);
+    }
+    return secondsSince(start);
+  });
+}
+
+// The empty board is the flood fill's worst case: one click opens every cell.
+static void floodBenchmark(const Preset& preset) {
+  GameState empty;
+  initBoard(empty, preset.rows, preset.cols, 0);
+  bench("openPosition.flood", {preset.rows, preset.cols, 0},
+        [&](int iterations) {
+          return onCopies(empty, iterations, [&](GameState& state, int) {
+            openPosition(state, 1, 1);
+          });
+        });
+}
+
+static void discard(void*, const char*, size_t) {}
+
+// render() into a terminal whose output is thrown away, once redrawing the
+// whole screen and once for a cursor move, on a half-solved board.
+static void renderBenchmarks(const Preset& preset) {
+  Terminal sink;
+  sink.session = &sink;
+  sink.writeOutput = discard;
+  sink.width = 200;
+  sink.height = 60;
+  Terminal* previous = setTerminal(&sink);
+
+  GameState state;
+  std::vector<CellPos> numbered;
+  chordBoard(preset, state, numbered);
+  for (size_t i = 0; i < numbered.size() / 2; i++)
+    openPosition(state, numbered[i].r, numbered[i].c);
+
+  bench("render.full", preset, [&](int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+      clearScreenInline(40);
+      render(state, 1, 1);
+    }
+    return secondsSince(start);
+  });
+
+  bench("render.move", preset, [&](int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++)
+      render(state, 1, 1 + (i & 1));
+    return secondsSince(start);
+  });
+
+  setTerminal(previous);
+}
+
+static bool writeResults(const char* path) {
+  FILE* file = fopen(path, "w");
+  if (!file)
+    return false;
+  for (const Result& result : results)
+    fprintf(file, "%s\t%.1f\n", result.name.c_str(), result.ns);
+  return fclose(file) == 0;
+}
+
+static void compareBaseline(const char* path) {
+  FILE* file = fopen(path, "r");
+  if (!file) {
+    printf("\nno baseline at %s\n", path);
+    return;
+  }
+  std::map<std::string, double> baseline;
+  char name[128];
+  double ns;
+  while (fscanf(file, "%127s %lf", name, &ns) == 2)
+    baseline[name] = ns;
+  fclose(file);
+
+  printf("\n%-44s %14s %14s %8s\n", "benchmark", "ns/op", "baseline",
+         "change");
+  for (const Result& result : results) {
+    auto found = baseline.find(result.name);
+    if (found == baseline.end()) {
+      printf("%-44s %14.1f %14s\n", result.name.c_str(), result.ns, "-");
+      continue;
+    }
+    double change = (result.ns / found->second - 1) * 100;
+    printf("%-44s %14.1f %14.1f %+7.1f%%%s\n", result.name.c_str(),
+           result.ns, found->second, change,
+           change > 10 ? "  slower" : change < -10 ? "  faster" : "");
+  }
+}
+
+int main(int argc, char* argv[]) {
+  const char* outPath = nullptr;
+  const char* baselinePath = nullptr;
+  for (int i = 1; i < argc; i++) {
+    const char* value = i + 1 < argc ? argv[i + 1] : "";
+    if (!strcmp(argv[i], "--out") && *value)
+      outPath = value, i++;
+    else if (!strcmp(argv[i], "--baseline") && *value)
+      baselinePath = value, i++;
+    else if (!strcmp(argv[i], "--filter") && *value)
+      filter = value, i++;
+    else {
+      fprintf(stderr,
+              "usage: %s [--out FILE] [--baseline FILE] [--filter TEXT]\n",
+              argv[0]);
+      return 1;
+    }
+  }
+
+  // Beginner to expert densities on the classic boards, then low and high
+  // densities on large ones.
+  const Preset presets[] = {{9, 9, 10},          {16, 16, 40},
+                            {16, 30, 99},        {100, 100, 1200},
+                            {100, 100, 2000},    {1000, 1000, 120000},
+                            {1000, 1000, 200000}};
+  const Preset floods[] = {{9, 9, 0}, {16, 30, 0}, {100, 100, 0},
+                           {1000, 1000, 0}};
+
+  printf("%-44s %14s\n", "benchmark", "ns/op");
+  for (const Preset& preset : presets)
+    engineBenchmarks(preset);
+  for (const Preset& preset : floods)
+    floodBenchmark(preset);
+  for (const Preset& preset : presets)
+    renderBenchmarks(preset);
+
+  if (outPath && !writeResults(outPath)) {
+    fprintf(stderr, "cannot write %s\n", outPath);
+    return 1;
+  }
+  if (baselinePath)
+    compareBaseline(baselinePath);
+  return 0;
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <chrono>
+#include <random>
+#include "../src/bitboard.h"
+#include "../src/game_controller.h"
+
+// Compares the bitboard neighbour counting used by genBoard against the
+// scalar per-cell loop on the same mine layouts.
+
+struct Preset {
+  int rows, cols, mines, repeats;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main() {
+  const Preset presets[] = {{9, 9, 10, 200000},      {16, 30, 99, 50000},
+                            {40, 40, 320, 20000},    {100, 130, 2600, 2000},
+                            {1000, 1000, 200000, 20}, {4000, 4000, 3200000, 2}};
+  std::mt19937_64 rng(12345);
+
+  printf("%-12s %12s %12s %8s\n", "board", "scalar ns", "bitboard ns",
+         "speedup");
+  for (const Preset& preset : presets) {
+    GameState scalar, bitboard;
+    MineBitboard mines;
+    initBoard(scalar, preset.rows, preset.cols, preset.mines);
+    initBoard(bitboard, preset.rows, preset.cols, preset.mines);
+    initBitboard(mines, preset.rows, preset.cols);
+    for (int placed = 0; placed < preset.mines;) {
+      int r = rng() % preset.rows + 1, c = rng() % preset.cols + 1;
+      if (testMineBit(mines, r, c))
+        continue;
+      setMineBit(mines, r, c);
+      scalar.cells[cellIndex(scalar, r, c)] |= CELL_MINE;
+      placed++;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < preset.repeats; i++)
+      countNeighboursScalar(scalar);
+    double scalarTime = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < preset.repeats; i++)
+      applyBitboard(mines, bitboard);
+    double bitboardTime = secondsSince(start);
+
+    for (int r = 1; r <= preset.rows; r++)
+      for (int c = 1; c <= preset.cols; c++)
+        if ((scalar.cells[cellIndex(scalar, r, c)] ^
+             bitboard.cells[cellIndex(bitboard, r, c)]) &
+            (CELL_COUNT | CELL_MINE)) {
+          fprintf(stderr, "mismatch at %dx%d (%d, %d)\n", preset.rows,
+                  preset.cols, r, c);
+          return 1;
+        }
+
+    char name[32];
+    snprintf(name, sizeof name, "%dx%d", preset.rows, preset.cols);
+    printf("%-12s %12.0f %12.0f %7.1fx\n", name,
+           scalarTime / preset.repeats * 1e9,
+           bitboardTime / preset.repeats * 1e9, scalarTime / bitboardTime);
+  }
+  return 0;
+}
@@ -0,0 +1,216 @@
+#include "analysis.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "solver.h"
+#include "thread_pool.h"
+
+BoardStats analyzeBoard(const GameState& state) {
+  static thread_local std::vector<unsigned char> seen;
+  static thread_local std::vector<int> stack;
+  int stride = state.stride;
+  int offset[8] = {-stride - 1, -stride, -stride + 1, -1,
+                   1,           stride - 1, stride,  stride + 1};
+  auto blank = [&](int index) {
+    return !(state.cells[index] & (CELL_MINE | CELL_COUNT));
+  };
+
+  // The border ring counts as seen so that the flood fill stops at it.
+  seen.assign(state.cells.size(), 1);
+  for (int r = 1; r <= state.rows; r++)
+    std::fill(seen.begin() + cellIndex(state, r, 1),
+              seen.begin() + cellIndex(state, r, state.cols) + 1, 0);
+
+  // Every blank cell starts or joins one opening, and the numbers around an
+  // opening are marked as revealed by it; each cell is pushed at most once.
+  BoardStats stats = {0, 0, 0};
+  for (int r = 1; r <= state.rows; r++)
+    for (int c = 1; c <= state.cols; c++) {
+      int start = cellIndex(state, r, c);
+      if (seen[start] || !blank(start))
+        continue;
+      stats.openings++;
+      seen[start] = 1;
+      stack.push_back(start);
+      while (!stack.empty()) {
+        int index = stack.back();
+        stack.pop_back();
+        for (int i = 0; i < 8; i++) {
+          int neighbour = index + offset[i];
+          if (seen[neighbour])
+            continue;
+          seen[neighbour] = 1;
+          if (blank(neighbour))
+            stack.push_back(neighbour);
+        }
+      }
+    }
+
+  for (int r = 1; r <= state.rows; r++)
+    for (int c = 1; c <= state.cols; c++) {
+      int index = cellIndex(state, r, c);
+      stats.isolated += !seen[index] && !(state.cells[index] & CELL_MINE);
+    }
+  stats.bbbv = stats.openings + stats.isolated;
+  return stats;
+}
+
+int guessesNeeded(const GameState& state, int r, int c) {
+  static thread_local GameState play;
+  play = state;
+  for (int pr = 1; pr <= play.rows; pr++)
+    for (int pc = 1; pc <= play.cols; pc++)
+      play.cells[cellIndex(play, pr, pc)] &= ~(CELL_OPENED | CELL_FLAG);
+  play.openedCount = 0;
+  play.flagCount = 0;
+  if (!openPosition(play, r, c))
+    return 0;
+
+  int stride = play.stride;
+  int offset[8] = {-stride - 1, -stride, -stride + 1, -1,
+                   1,           stride - 1, stride,  stride + 1};
+  int guesses = 0;
+  while (propagate(play) && !isWinState(play)) {
+    // Hidden safe cells next to an opened number are where a player would
+    // guess; the border is opened but has no number. Any hidden safe cell
+    // will do if none is.
+    int guess = -1, fallback = -1;
+    for (int pr = 1; pr <= play.rows && guess < 0; pr++)
+      for (int pc = 1; pc <= play.cols; pc++) {
+        int index = cellIndex(play, pr, pc);
+        if (play.cells[index] & (CELL_MINE | CELL_OPENED))
+          continue;
+        if (fallback < 0)
+          fallback = index;
+        bool frontier = false;
+        for (int i = 0; i < 8 && !frontier; i++) {
+          unsigned char neighbour = play.cells[index + offset[i]];
+          frontier = (neighbour & CELL_OPENED) && (neighbour & CELL_COUNT);
+        }
+        if (frontier) {
+          guess = index;
+          break;
+        }
+      }
+    if (guess < 0)
+      guess = fallback;
+    guesses++;
+    openPosition(play, guess / stride, guess % stride);
+  }
+  return guesses;
+}
+
+// Every statistic is a small count, so a batch is summarized from a
+// histogram per worker instead of keeping every value.
+typedef std::vector<long> Histogram;
+
+static void addValue(Histogram& histogram, int value) {
+  if ((size_t)value >= histogram.size())
+    histogram.resize(value + 1, 0);
+  histogram[value]++;
+}
+
+static StatSummary summarize(const Histogram& histogram) {
+  StatSummary summary = {0, 0, 0, 0, 0, 0, 0};
+  long total = 0;
+  double sum = 0;
+  for (size_t value = 0; value < histogram.size(); value++) {
+    total += histogram[value];
+    sum += (double)value * histogram[value];
+  }
+  if (total == 0)
+    return summary;
+  summary.mean = sum / total;
+
+  const double quantiles[5] = {0, 0.1, 0.5, 0.9, 0.99};
+  int* targets[5] = {&summary.min, &summary.p10, &summary.p50, &summary.p90,
+                     &summary.p99};
+  long seen = 0;
+  int next = 0;
+  for (size_t value = 0; value < histogram.size(); value++) {
+    if (!histogram[value])
+      continue;
+    seen += histogram[value];
+    while (next < 5 && seen > quantiles[next] * total)
+      *targets[next++] = value;
+    summary.max = value;
+  }
+  return summary;
+}
+
+AnalysisReport runAnalysis(const SimulationOptions& options) {
+  int threads = options.threads > 0 ? options.threads : defaultThreadCount();
+  const int STATS = 4;
+  std::vector<Histogram> histograms(threads * STATS);
+  auto start = std::chrono::steady_clock::now();
+  parallelFor(options.games, threads, 256, [&](int worker, long begin,
+                                               long end) {
+    static thread_local GameState state;
+    static thread_local Rng rng;
+
+    Histogram* stats = &histograms[worker * STATS];
+    int r = (options.rows + 1) / 2, c = (options.cols + 1) / 2;
+    for (long index = begin; index < end; index++) {
+      seedRng(rng, deriveSeed(options.seed, index), options.rngKind);
+      initBoard(state, options.rows, options.cols, options.mines);
+      if (options.noGuess) {
+        bool solvable;
+        genBoardNoGuess(state, r, c, nextRandom(rng), rng.kind,
+                        NO_GUESS_ATTEMPTS, solvable);
+      } else {
+        genBoard(state, r, c, nextRandom(rng), rng.kind);
+      }
+      BoardStats board = analyzeBoard(state);
+      addValue(stats[0], board.bbbv);
+      addValue(stats[1], board.openings);
+      addValue(stats[2], board.isolated);
+      addValue(stats[3], guessesNeeded(state, r, c));
+    }
+  });
+
+  AnalysisReport report;
+  report.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  report.boards = options.games;
+  Histogram merged[STATS];
+  for (int worker = 0; worker < threads; worker++)
+    for (int stat = 0; stat < STATS; stat++) {
+      const Histogram& histogram = histograms[worker * STATS + stat];
+      if (merged[stat].size() < histogram.size())
+        merged[stat].resize(histogram.size(), 0);
+      for (size_t value = 0; value < histogram.size(); value++)
+        merged[stat][value] += histogram[value];
+    }
+  report.bbbv = summarize(merged[0]);
+  report.openings = summarize(merged[1]);
+  report.isolated = summarize(merged[2]);
+  report.guesses = summarize(merged[3]);
+  return report;
+}
+
+static void printSummary(const char* name, const StatSummary& summary) {
+  printf("%-10s %8.2f %6d %6d %6d %6d %6d %6d\n", name, summary.mean,
+         summary.min, summary.p10, summary.p50, summary.p90, summary.p99,
+         summary.max);
+}
+
+void printAnalysisReport(const SimulationOptions& options,
+                         const AnalysisReport& report) {
+  printf("board:     %dx%d, %d mines%s\n", options.rows, options.cols,
+         options.mines, options.noGuess ? ", no-guess" : "");
+  printf("seed:      %llu (%s)\n", (unsigned long long)options.seed,
+         options.rngKind == RNG_MT19937 ? "mt19937_64" : "xoshiro256**");
+  printf("threads:   %d\n",
+         options.threads > 0 ? options.threads : defaultThreadCount());
+  printf("boards:    %ld in %.3fs\n", report.boards, report.seconds);
+  printf("boards/s:  %.0f\n\n",
+         report.seconds > 0 ? report.boards / report.seconds : 0.0);
+  printf("%-10s %8s %6s %6s %6s %6s %6s %6s\n", "", "mean", "min", "p10",
+         "p50", "p90", "p99", "max");
+  printSummary("3BV", report.bbbv);
+  printSummary("openings", report.openings);
+  printSummary("isolated", report.isolated);
+  printSummary("guesses", report.guesses);
+}
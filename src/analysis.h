@@ -0,0 +1,43 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+#include "game_controller.h"
+#include "simulator.h"
+
+// Difficulty of a generated board, from the mines alone.
+struct BoardStats {
+  // Bechtel's Board Benchmark Value: the fewest clicks that clear the board,
+  // one per opening plus one per number no opening reveals.
+  int bbbv;
+  // Connected (8-neighbour) regions of cells with no neighbouring mine.
+  int openings;
+  // Numbers that no opening reveals.
+  int isolated;
+};
+
+// One labelling pass over the cells.
+BoardStats analyzeBoard(const GameState& state);
+
+// Solver effort: opens (r, c) on a copy of the board and counts how often
+// propagate() gets stuck before the board is cleared, each time opening a safe
+// cell next to the opened area as a lucky guess would. 0 for a no-guess board.
+int guessesNeeded(const GameState& state, int r, int c);
+
+// Percentiles of one statistic over a batch.
+struct StatSummary {
+  double mean;
+  int min, p10, p50, p90, p99, max;
+};
+
+struct AnalysisReport {
+  long boards;
+  double seconds;
+  StatSummary bbbv, openings, isolated, guesses;
+};
+
+// Generates options.games boards exactly as runSimulation() does (board i
+// from deriveSeed(seed, i), first click in the centre) and analyzes each.
+AnalysisReport runAnalysis(const SimulationOptions& options);
+void printAnalysisReport(const SimulationOptions& options,
+                         const AnalysisReport& report);
+
+#endif
@@ -0,0 +1,144 @@
+#include "autosave.h"
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "savefile.h"
+
+struct CellChange {
+  int index;
+  unsigned char cell;
+};
+
+static std::mutex mutex;
+static std::condition_variable wake, idle;
+static std::thread writer;
+// The game thread stages whole boards in `snapshot` and swaps them into
+// `pending`; changed cells queue up in `changes` behind it. The writer
+// applies both to `mirror`, its own copy of the game, and encodes that into
+// `writing`. Only the scalar fields of `pending` are used once its cells have
+// been taken.
+static GameState snapshot, pending, mirror;
+static std::vector<CellChange> changes;
+static std::vector<unsigned char> writing;
+static std::string pendingPath, writingPath;
+static bool hasPending, hasBoard, busy, stopping;
+static int flushing;
+
+// Everything but the cells and the scratch space.
+static void copyFields(const GameState& from, GameState& to) {
+  to.rows = from.rows;
+  to.cols = from.cols;
+  to.stride = from.stride;
+  to.bombCount = from.bombCount;
+  to.elapsedTime = from.elapsedTime;
+  to.openedCount = from.openedCount;
+  to.flagCount = from.flagCount;
+  to.seed = from.seed;
+  to.rngKind = from.rngKind;
+  to.symmetry = from.symmetry;
+  to.noGuess = from.noGuess;
+  to.generated = from.generated;
+}
+
+static void writerLoop() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (true) {
+    wake.wait(lock, [] { return hasPending || stopping; });
+    if (!hasPending)
+      return;
+
+    if (hasBoard)
+      mirror.cells.swap(pending.cells);
+    hasBoard = false;
+    for (const CellChange& change : changes)
+      if ((size_t)change.index < mirror.cells.size())
+        mirror.cells[change.index] = change.cell;
+    changes.clear();
+    copyFields(pending, mirror);
+    pendingPath.swap(writingPath);
+    hasPending = false;
+    busy = true;
+    lock.unlock();
+
+    // Changes without a whole board before them (misuse) are not written.
+    auto start = std::chrono::steady_clock::now();
+    if (mirror.cells.size() ==
+        (size_t)(mirror.rows + 2) * (mirror.cols + 2)) {
+      encodeSave(mirror, writing);
+      writeFileAtomic(writingPath.c_str(), writing);
+    }
+    auto took = std::chrono::steady_clock::now() - start;
+
+    lock.lock();
+    busy = false;
+    idle.notify_all();
+    // Large boards take long enough to encode and write that saving after
+    // every move would keep a core busy, so the writer rests three times as
+    // long as the last save took. Flushing and stopping cut the rest short.
+    wake.wait_until(lock, std::chrono::steady_clock::now() + took * 3,
+                    [] { return flushing > 0 || stopping; });
+  }
+}
+
+static void queueSave(const char* path) {
+  pendingPath = path;
+  hasPending = true;
+  if (!writer.joinable()) {
+    stopping = false;
+    writer = std::thread(writerLoop);
+  }
+  wake.notify_one();
+}
+
+void autosave(const GameState& state, const char* path) {
+  snapshot.cells = state.cells;
+  std::lock_guard<std::mutex> lock(mutex);
+  snapshot.cells.swap(pending.cells);
+  copyFields(state, pending);
+  changes.clear();
+  hasBoard = true;
+  queueSave(path);
+}
+
+void autosave(const GameState& state,
+              const char* path,
+              const std::vector<CellPos>& changed) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (const CellPos& cell : changed) {
+    int index = cellIndex(state, cell.r, cell.c);
+    changes.push_back({index, state.cells[index]});
+  }
+  copyFields(state, pending);
+  queueSave(path);
+}
+
+void flushAutosave() {
+  std::unique_lock<std::mutex> lock(mutex);
+  flushing++;
+  wake.notify_one();
+  idle.wait(lock, [] { return !hasPending && !busy; });
+  flushing--;
+}
+
+void cancelAutosave() {
+  std::unique_lock<std::mutex> lock(mutex);
+  hasPending = false;
+  hasBoard = false;
+  changes.clear();
+  idle.wait(lock, [] { return !busy; });
+}
+
+void stopAutosave() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!writer.joinable())
+      return;
+    stopping = true;
+    wake.notify_one();
+  }
+  // The writer drains the pending snapshot before it sees `stopping`.
+  writer.join();
+}
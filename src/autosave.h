@@ -0,0 +1,32 @@
+#ifndef AUTOSAVE_H
+#define AUTOSAVE_H
+#include <vector>
+#include "game_controller.h"
+
+// Background saving: a writer thread, started on first use, keeps its own
+// copy of the game, encodes it and writes it with writeFileAtomic(), so the
+// game thread never encodes a board or waits for the disk. Saves that arrive
+// while a write is in flight are merged, and on large boards the writer
+// rests between writes (see writerLoop()), so the file may trail the game by
+// a few moves until flushAutosave().
+//
+// The first save of a game hands over the whole board, one copy of the cells.
+void autosave(const GameState& state, const char* path);
+// Later saves hand over only the cells whose state changed since the previous
+// save (opened by openPosition() or flagged), so they cost as much as the
+// move, whatever the size of the board.
+void autosave(const GameState& state,
+              const char* path,
+              const std::vector<CellPos>& changed);
+
+// Blocks until every queued snapshot is on disk.
+void flushAutosave();
+
+// Drops the queued snapshot and waits for a write in flight, so that the
+// save file can be removed without being written again afterwards.
+void cancelAutosave();
+
+// Flushes and stops the writer thread.
+void stopAutosave();
+
+#endif
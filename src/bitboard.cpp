@@ -0,0 +1,112 @@
+#include "bitboard.h"
+#include <string.h>
+#include <array>
+
+// spread[v] has byte i set to bit i of v, in memory order, so that eight
+// cells can be written with a single 64-bit store on any endianness.
+static const std::array<uint64_t, 256>& spreadTable() {
+  static const std::array<uint64_t, 256> table = [] {
+    std::array<uint64_t, 256> result;
+    for (int v = 0; v < 256; v++) {
+      unsigned char bytes[8];
+      for (int i = 0; i < 8; i++)
+        bytes[i] = v >> i & 1;
+      memcpy(&result[v], bytes, 8);
+    }
+    return result;
+  }();
+  return table;
+}
+
+void initBitboard(MineBitboard& mines, int rows, int cols) {
+  mines.rows = rows;
+  mines.cols = cols;
+  mines.words = (cols + 2 + 63) / 64;
+  mines.bits.assign((size_t)(rows + 2) * mines.words, 0);
+}
+
+void applyBitboard(const MineBitboard& mines, GameState& state) {
+  const std::array<uint64_t, 256>& spread = spreadTable();
+  const uint64_t countMask = 0x1f1f1f1f1f1f1f1fULL;
+  int words = mines.words;
+  int width = state.cols + 2;
+
+  for (int r = 1; r <= state.rows; r++) {
+    const uint64_t* rowBits[3] = {&mines.bits[(size_t)(r - 1) * words],
+                                  &mines.bits[(size_t)r * words],
+                                  &mines.bits[(size_t)(r + 1) * words]};
+    unsigned char* row = &state.cells[cellIndex(state, r, 0)];
+
+    for (int w = 0; w < words; w++) {
+      // Bit-sliced adder: each of the three rows contributes its west and
+      // east neighbour (and its own bit for the rows above and below); the
+      // eight one-bit inputs are summed into the four bit planes p0..p3.
+      uint64_t ones[3], twos[3];
+      for (int i = 0; i < 3; i++) {
+        uint64_t x = rowBits[i][w];
+        uint64_t prev = w > 0 ? rowBits[i][w - 1] : 0;
+        uint64_t next = w + 1 < words ? rowBits[i][w + 1] : 0;
+        uint64_t west = x << 1 | prev >> 63;
+        uint64_t east = x >> 1 | next << 63;
+        if (i == 1) {
+          ones[i] = west ^ east;
+          twos[i] = west & east;
+        } else {
+          ones[i] = west ^ x ^ east;
+          twos[i] = (west & x) | (east & (west ^ x));
+        }
+      }
+      uint64_t p0 = ones[0] ^ ones[1] ^ ones[2];
+      uint64_t carry =
+          (ones[0] & ones[1]) | (ones[2] & (ones[0] ^ ones[1]));
+      uint64_t t = twos[0] ^ twos[1] ^ twos[2];
+      uint64_t fours =
+          (twos[0] & twos[1]) | (twos[2] & (twos[0] ^ twos[1]));
+      uint64_t p1 = t ^ carry;
+      uint64_t fours2 = t & carry;
+      uint64_t p2 = fours ^ fours2;
+      uint64_t p3 = fours & fours2;
+      uint64_t mine = rowBits[1][w];
+
+      for (int k = 0; k < 8; k++) {
+        int col = w * 64 + k * 8;
+        if (col >= width)
+          break;
+        int shift = k * 8;
+        uint64_t packed = spread[p0 >> shift & 255] |
+                          spread[p1 >> shift & 255] << 1 |
+                          spread[p2 >> shift & 255] << 2 |
+                          spread[p3 >> shift & 255] << 3 |
+                          spread[mine >> shift & 255] << 4;
+        if (col + 8 <= width) {
+          uint64_t current;
+          memcpy(&current, row + col, 8);
+          current = (current & ~countMask) | packed;
+          memcpy(row + col, &current, 8);
+        } else {
+          unsigned char bytes[8];
+          memcpy(bytes, &packed, 8);
+          for (int i = 0; col + i < width; i++)
+            row[col + i] = (row[col + i] & ~0x1f) | bytes[i];
+        }
+      }
+    }
+    // The border columns are sentinels, not numbers.
+    row[0] &= ~CELL_COUNT;
+    row[width - 1] &= ~CELL_COUNT;
+  }
+}
+
+void countNeighboursScalar(GameState& state) {
+  const int dr[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
+  const int dc[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
+
+  for (int r = 1; r <= state.rows; r++)
+    for (int c = 1; c <= state.cols; c++) {
+      int count = 0;
+      for (int i = 0; i < 8; i++)
+        count += isMine(state, r + dr[i], c + dc[i]);
+      unsigned char& cell = state.cells[cellIndex(state, r, c)];
+      cell = (cell & ~CELL_COUNT) | count;
+    }
+}
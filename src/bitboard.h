@@ -0,0 +1,34 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "game_controller.h"
+
+// Mines as one bitset per row, padded like GameState::cells: bit c of row r
+// is board position (r, c), rows 0 and rows + 1 and columns 0 and cols + 1
+// are always empty.
+struct MineBitboard {
+  std::vector<uint64_t> bits;
+  int rows, cols, words;
+};
+
+void initBitboard(MineBitboard& mines, int rows, int cols);
+
+inline void setMineBit(MineBitboard& mines, int r, int c) {
+  mines.bits[(size_t)r * mines.words + (c >> 6)] |= (uint64_t)1 << (c & 63);
+}
+
+inline bool testMineBit(const MineBitboard& mines, int r, int c) {
+  return mines.bits[(size_t)r * mines.words + (c >> 6)] >> (c & 63) & 1;
+}
+
+// Writes the mine bits and all neighbour counts into state.cells in one pass,
+// 64 cells per word operation. Opened and flag bits are left untouched.
+void applyBitboard(const MineBitboard& mines, GameState& state);
+
+// Reference implementation counting each cell's neighbours one at a time
+// from the mine bits already stored in state.cells.
+void countNeighboursScalar(GameState& state);
+
+#endif
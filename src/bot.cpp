@@ -0,0 +1,216 @@
+#include "bot.h"
+#include <string.h>
+#include <chrono>
+#include "solver.h"
+
+static const int HIDDEN = 9, FLAGGED = 10;
+
+// The single-cell rules of the simulator's autoPlay(): a number with as many
+// flags as its count chords, one with as many flags and hidden neighbours as
+// its count flags them. A random hidden cell is the guess.
+class RulesBot : public BotStrategy {
+ public:
+  void newGame(const BotView&, uint64_t seed) override { seedRng(rng_, seed); }
+
+  void decide(const BotView& view, std::vector<BotAction>& actions) override {
+    // Flags decided in this round are marked at once, so that two numbers
+    // sharing a cell do not flag it twice.
+    seen_.assign(view.cells, view.cells + view.rows * view.cols);
+    for (int r = 1; r <= view.rows; r++)
+      for (int c = 1; c <= view.cols; c++) {
+        int number = at(view, r, c);
+        if (number == 0 || number > 8)
+          continue;
+
+        int hidden = 0, flags = 0;
+        for (int dr = -1; dr <= 1; dr++)
+          for (int dc = -1; dc <= 1; dc++) {
+            int neighbour = at(view, r + dr, c + dc);
+            hidden += neighbour == HIDDEN;
+            flags += neighbour == FLAGGED;
+          }
+        if (hidden == 0)
+          continue;
+        if (flags == number) {
+          actions.push_back({BOT_CHORD, r, c});
+        } else if (flags + hidden == number) {
+          for (int dr = -1; dr <= 1; dr++)
+            for (int dc = -1; dc <= 1; dc++)
+              if (at(view, r + dr, c + dc) == HIDDEN) {
+                seen_[(r + dr - 1) * view.cols + c + dc - 1] = FLAGGED;
+                actions.push_back({BOT_FLAG, r + dr, c + dc});
+              }
+        }
+      }
+    if (!actions.empty())
+      return;
+
+    long total = (long)view.rows * view.cols, hidden = 0;
+    for (long i = 0; i < total; i++)
+      hidden += seen_[i] == HIDDEN;
+    if (hidden == 0)
+      return;
+    long pick = randomBelow(rng_, hidden);
+    for (long i = 0; i < total; i++)
+      if (seen_[i] == HIDDEN && pick-- == 0) {
+        actions.push_back({BOT_OPEN, (int)(i / view.cols) + 1,
+                           (int)(i % view.cols) + 1});
+        return;
+      }
+  }
+
+ private:
+  // Outside the board reads as an opened blank.
+  int at(const BotView& view, int r, int c) const {
+    if (r < 1 || c < 1 || r > view.rows || c > view.cols)
+      return 0;
+    return seen_[(r - 1) * view.cols + c - 1];
+  }
+
+  Rng rng_;
+  std::vector<unsigned char> seen_;
+};
+
+// Asks the solver: opens every provably safe cell, flags every certain mine,
+// and when nothing is certain opens the cell least likely to be a mine.
+class HintsBot : public BotStrategy {
+ public:
+  void newGame(const BotView& view, uint64_t) override {
+    initBoard(visible_, view.rows, view.cols, view.mines);
+  }
+
+  void decide(const BotView& view, std::vector<BotAction>& actions) override {
+    // computeHints() only reads opened numbers, so a state holding nothing
+    // but what the view shows is enough.
+    visible_.openedCount = 0;
+    visible_.flagCount = view.flags;
+    for (int r = 1; r <= view.rows; r++)
+      for (int c = 1; c <= view.cols; c++) {
+        int seen = view.at(r, c);
+        unsigned char& cell = visible_.cells[cellIndex(visible_, r, c)];
+        if (seen <= 8) {
+          cell = CELL_OPENED | seen;
+          visible_.openedCount++;
+        } else {
+          cell = seen == FLAGGED ? CELL_FLAG : 0;
+        }
+      }
+    computeHints(visible_, hints_);
+
+    for (const CellPos& cell : hints_.safe)
+      if (view.at(cell.r, cell.c) == HIDDEN)
+        actions.push_back({BOT_OPEN, cell.r, cell.c});
+    for (const CellPos& cell : hints_.mines)
+      if (view.at(cell.r, cell.c) == HIDDEN)
+        actions.push_back({BOT_FLAG, cell.r, cell.c});
+    for (const BotAction& action : actions)
+      if (action.kind == BOT_OPEN)
+        return;
+
+    float best = 2;
+    BotAction guess = {BOT_OPEN, 0, 0};
+    for (int r = 1; r <= view.rows; r++)
+      for (int c = 1; c <= view.cols; c++) {
+        float probability = hints_.probability[cellIndex(visible_, r, c)];
+        if (view.at(r, c) == HIDDEN && probability >= 0 && probability < best) {
+          best = probability;
+          guess.r = r;
+          guess.c = c;
+        }
+      }
+    if (guess.r)
+      actions.push_back(guess);
+  }
+
+ private:
+  GameState visible_;
+  Hints hints_;
+};
+
+template <class T>
+static std::unique_ptr<BotStrategy> createBot() {
+  return std::unique_ptr<BotStrategy>(new T());
+}
+
+const std::vector<BotInfo>& botStrategies() {
+  static const std::vector<BotInfo> strategies = {
+      {"rules", "single-cell rules, random guesses", createBot<RulesBot>},
+      {"hints", "solver hints, least likely mine as the guess",
+       createBot<HintsBot>},
+  };
+  return strategies;
+}
+
+const BotInfo* findBotStrategy(const char* name) {
+  for (const BotInfo& info : botStrategies())
+    if (!strcmp(info.name, name))
+      return &info;
+  return nullptr;
+}
+
+BotResult playBot(Game& game,
+                  BotStrategy& strategy,
+                  uint64_t seed,
+                  std::vector<int64_t>* latencies) {
+  static thread_local std::vector<unsigned char> cells;
+  static thread_local std::vector<CellPos> opened;
+  static thread_local std::vector<BotAction> actions;
+  const Board& board = game.board();
+  int rows = board.rows(), cols = board.cols();
+  cells.assign((size_t)rows * cols, HIDDEN);
+  opened.clear();
+  BotView view = {rows, cols, board.mines(), 0, cells.data()};
+  BotResult result = {GAME_PLAYING, 0, 0};
+  // The view follows every open at once: an action that meant a hidden cell
+  // must not chord it after an earlier action flooded it open.
+  auto open = [&](int r, int c) {
+    game.open(r, c, &opened);
+    for (const CellPos& cell : opened)
+      cells[(cell.r - 1) * cols + cell.c - 1] = board.display(cell.r, cell.c);
+    opened.clear();
+  };
+
+  game.setSeed(seed);
+  open((rows + 1) / 2, (cols + 1) / 2);
+  // A different stream from the board's, so guesses do not follow the mines.
+  strategy.newGame(view, deriveSeed(seed, 1));
+
+  long stalled = 0;
+  while (game.status() == GAME_PLAYING && stalled < (long)rows * cols) {
+    view.flags = board.flagCount();
+
+    actions.clear();
+    auto start = std::chrono::steady_clock::now();
+    strategy.decide(view, actions);
+    if (latencies)
+      latencies->push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now() - start)
+                               .count());
+    result.decisions++;
+    if (actions.empty())
+      break;
+
+    int openedBefore = board.openedCount();
+    for (const BotAction& action : actions) {
+      if (game.status() != GAME_PLAYING)
+        break;
+      if (!board.inBounds(action.r, action.c))
+        continue;
+      int seen = cells[(action.r - 1) * cols + action.c - 1];
+      if (action.kind == BOT_FLAG && (seen == HIDDEN || seen == FLAGGED)) {
+        game.toggleFlag(action.r, action.c);
+        cells[(action.r - 1) * cols + action.c - 1] =
+            seen == HIDDEN ? FLAGGED : HIDDEN;
+      } else if ((action.kind == BOT_OPEN && seen == HIDDEN) ||
+                 (action.kind == BOT_CHORD && seen <= 8)) {
+        open(action.r, action.c);
+      } else {
+        continue;
+      }
+      result.moves++;
+    }
+    stalled = board.openedCount() > openedBefore ? 0 : stalled + 1;
+  }
+  result.status = game.status();
+  return result;
+}
@@ -0,0 +1,67 @@
+#ifndef BOT_H
+#define BOT_H
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include "engine.h"
+
+// Headless players. A strategy sees only what a player would, the displayAt()
+// codes of the board, and answers with actions; playBot() applies them to a
+// Game. Strategies are not shared between threads: every thread creates its
+// own from the registry.
+
+enum BotActionKind { BOT_OPEN, BOT_FLAG, BOT_CHORD };
+
+struct BotAction {
+  BotActionKind kind;
+  int r, c;
+};
+
+// The board as the player sees it: cells[(r - 1) * cols + c - 1] is the
+// displayAt() code of (r, c), 0-8 for numbers, 9 hidden and 10 flagged.
+struct BotView {
+  int rows, cols, mines, flags;
+  const unsigned char* cells;
+
+  int at(int r, int c) const { return cells[(r - 1) * cols + c - 1]; }
+};
+
+class MINESWEEPER_API BotStrategy {
+ public:
+  virtual ~BotStrategy() = default;
+
+  // Called before every game; the seed is for any randomness the strategy
+  // uses, so that a game is played the same way every time.
+  virtual void newGame(const BotView& view, uint64_t seed) = 0;
+  // Appends the next actions. They are applied in order until the game ends,
+  // then decide() is called again with the new view. No actions resigns.
+  virtual void decide(const BotView& view, std::vector<BotAction>& actions) = 0;
+};
+
+struct BotInfo {
+  const char* name;
+  const char* description;
+  std::unique_ptr<BotStrategy> (*create)();
+};
+
+// The built-in strategies, in the order tournaments list them.
+MINESWEEPER_API const std::vector<BotInfo>& botStrategies();
+MINESWEEPER_API const BotInfo* findBotStrategy(const char* name);
+
+struct BotResult {
+  GameStatus status;
+  long moves, decisions;
+};
+
+// Plays a game that has not been opened yet. The board is generated from
+// `seed` and its centre cell opened for the bot, so that every strategy
+// starts from the same position; decide() drives the rest. A strategy that
+// resigns, or makes no progress in rows * cols decisions, leaves the game
+// GAME_PLAYING. Decision times in nanoseconds are appended to `latencies`
+// if it is given.
+MINESWEEPER_API BotResult playBot(Game& game,
+                                  BotStrategy& strategy,
+                                  uint64_t seed,
+                                  std::vector<int64_t>* latencies = nullptr);
+
+#endif
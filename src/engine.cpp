@@ -0,0 +1,85 @@
+#include "engine.h"
+#include <utility>
+#include "savefile.h"
+#include "solver.h"
+
+Board::Board(int rows, int cols, int mines) {
+  initBoard(state_, rows, cols, mines);
+}
+
+bool Board::validSize(int rows, int cols, int mines) {
+  // The limits of decodeSave(): rows and columns are 16 bits in the save
+  // format, and there are at most MAX_SAVE_CELLS cells.
+  return rows >= 1 && cols >= 1 && rows <= 65535 && cols <= 65535 &&
+         (long long)rows * cols <= MAX_SAVE_CELLS && mines >= 1 &&
+         mines < rows * cols;
+}
+
+void Board::generate(int r, int c, uint64_t seed, RngKind kind) {
+  genBoard(state_, r, c, seed, kind);
+}
+
+bool Board::generateNoGuess(int r, int c, uint64_t seed, RngKind kind) {
+  bool solvable;
+  state_.noGuess = true;
+  genBoardNoGuess(state_, r, c, seed, kind, NO_GUESS_ATTEMPTS, solvable);
+  return solvable;
+}
+
+Game::Game(int rows, int cols, int mines, bool noGuess)
+    : board_(rows, cols, mines) {
+  board_.state_.noGuess = noGuess;
+}
+
+void Game::setSeed(uint64_t seed, RngKind kind) {
+  seeded_ = true;
+  seed_ = seed;
+  kind_ = kind;
+}
+
+GameStatus Game::open(int r, int c, std::vector<CellPos>* opened) {
+  GameState& state = board_.state_;
+  if (status_ != GAME_PLAYING || !inBound(state, r, c))
+    return status_;
+  if (!state.generated) {
+    uint64_t seed = seeded_ ? seed_ : randomSeed();
+    if (state.noGuess)
+      board_.generateNoGuess(r, c, seed, kind_);
+    else
+      board_.generate(r, c, seed, kind_);
+  }
+  if (!openPosition(state, r, c, opened))
+    status_ = GAME_LOST;
+  else if (isWinState(state))
+    status_ = GAME_WON;
+  return status_;
+}
+
+bool Game::toggleFlag(int r, int c) {
+  GameState& state = board_.state_;
+  if (status_ != GAME_PLAYING || !inBound(state, r, c) ||
+      board_.isOpened(r, c))
+    return false;
+  toggleFlagPosition(state, r, c);
+  return true;
+}
+
+void Game::save(std::vector<unsigned char>& out) const {
+  encodeSave(board_.state_, out);
+}
+
+bool Game::load(const unsigned char* data, size_t size) {
+  GameState state;
+  if (!decodeSave(data, size, state))
+    return false;
+  board_.state_ = std::move(state);
+  seeded_ = false;
+  status_ = isWinState(board_.state_) ? GAME_WON : GAME_PLAYING;
+  for (int r = 1; r <= board_.rows() && status_ == GAME_PLAYING; r++)
+    for (int c = 1; c <= board_.cols(); c++)
+      if (board_.isOpened(r, c) && board_.isMine(r, c)) {
+        status_ = GAME_LOST;
+        break;
+      }
+  return true;
+}
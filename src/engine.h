@@ -0,0 +1,116 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "engine_c.h"
+#include "game_controller.h"
+#include "rng.h"
+
+// The C++ API of libminesweeper. Every instance owns its state and the engine
+// keeps its scratch space per thread, so separate instances can be used from
+// separate threads at once; a single instance is not synchronised. Instances
+// move but do not copy. Once a board has done its first flood fill, opening
+// and flagging cells no longer allocate.
+
+enum GameStatus {
+  GAME_PLAYING = MS_PLAYING,
+  GAME_WON = MS_WON,
+  GAME_LOST = MS_LOST
+};
+
+// A minefield and what has been opened and flagged on it. Coordinates are
+// 1-based, as everywhere in the engine.
+class MINESWEEPER_API Board {
+ public:
+  // The size must pass validSize(); mines are placed by generate().
+  Board(int rows, int cols, int mines);
+  Board(Board&&) = default;
+  Board& operator=(Board&&) = default;
+  Board(const Board&) = delete;
+  Board& operator=(const Board&) = delete;
+
+  // At least one mine, room for a free first click, and no larger than a
+  // save file accepts, so every valid game can be saved and loaded again.
+  static bool validSize(int rows, int cols, int mines);
+
+  // Places the mines from `seed`, keeping (r, c) free (and its neighbours
+  // too with noGuess). The same seed always gives the same board.
+  void generate(int r, int c, uint64_t seed, RngKind kind = RNG_XOSHIRO);
+  // Regenerates from seeds derived from `seed` until the board can be solved
+  // from (r, c) without guessing; false if no attempt could.
+  bool generateNoGuess(int r, int c, uint64_t seed, RngKind kind = RNG_XOSHIRO);
+
+  int rows() const { return state_.rows; }
+  int cols() const { return state_.cols; }
+  int mines() const { return state_.bombCount; }
+  int openedCount() const { return state_.openedCount; }
+  int flagCount() const { return state_.flagCount; }
+  bool generated() const { return state_.generated; }
+  uint64_t seed() const { return state_.seed; }
+  // Inline from the public accessors: the engine's inBound() is not exported.
+  bool inBounds(int r, int c) const {
+    return r >= 1 && r <= rows() && c >= 1 && c <= cols();
+  }
+
+  // What a player sees at (r, c), as displayAt() codes: 0-8 numbers,
+  // 9 hidden, 10 flag, 11 mine, 12 wrong flag.
+  int display(int r, int c) const { return displayAt(state_, r, c); }
+  bool isMine(int r, int c) const { return cell(r, c) & CELL_MINE; }
+  bool isOpened(int r, int c) const { return cell(r, c) & CELL_OPENED; }
+  bool isFlagged(int r, int c) const { return cell(r, c) & CELL_FLAG; }
+  // Neighbouring mines, known only once the board is generated.
+  int count(int r, int c) const { return cell(r, c) & CELL_COUNT; }
+
+  // The engine's representation, for the free functions of the engine
+  // headers (solver, save format).
+  const GameState& state() const { return state_; }
+
+ private:
+  friend class Game;
+  unsigned char cell(int r, int c) const {
+    return state_.cells[cellIndex(state_, r, c)];
+  }
+
+  GameState state_;
+};
+
+// A game in progress: opening the first cell generates the board around it,
+// opening an opened number chords, and opening a mine ends the game.
+class MINESWEEPER_API Game {
+ public:
+  Game(int rows, int cols, int mines, bool noGuess = false);
+  Game(Game&&) = default;
+  Game& operator=(Game&&) = default;
+  Game(const Game&) = delete;
+  Game& operator=(const Game&) = delete;
+
+  // Seed for the board generated by the first open(); a random one is used
+  // if this is not called.
+  void setSeed(uint64_t seed, RngKind kind = RNG_XOSHIRO);
+
+  // Opens or chords (r, c) and returns the resulting status. Cells revealed
+  // are appended to `opened` if it is given. Does nothing once the game is
+  // over or outside the board.
+  GameStatus open(int r, int c, std::vector<CellPos>* opened = nullptr);
+  // Flags or unflags a hidden cell; false if nothing changed.
+  bool toggleFlag(int r, int c);
+
+  GameStatus status() const { return status_; }
+  const Board& board() const { return board_; }
+
+  // Serialises to the save file format (savefile.h).
+  void save(std::vector<unsigned char>& out) const;
+  // Replaces this game with saved data; false, leaving it untouched, if the
+  // data is rejected.
+  bool load(const unsigned char* data, size_t size);
+
+ private:
+  Board board_;
+  GameStatus status_ = GAME_PLAYING;
+  bool seeded_ = false;
+  uint64_t seed_ = 0;
+  RngKind kind_ = RNG_XOSHIRO;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include "engine_c.h"
+#include <string.h>
+#include "engine.h"
+
+// An ms_game is a Game; the C type only exists to keep the class opaque.
+// Exceptions (only std::bad_alloc can occur) must not cross into C, so every
+// function that can allocate catches them.
+struct ms_game {
+  Game game;
+};
+
+static_assert((int)GAME_PLAYING == MS_PLAYING && (int)GAME_WON == MS_WON &&
+                  (int)GAME_LOST == MS_LOST,
+              "C status codes must match GameStatus");
+
+ms_game* ms_game_new(int rows, int cols, int mines, int no_guess) {
+  if (!Board::validSize(rows, cols, mines))
+    return nullptr;
+  try {
+    return new ms_game{Game(rows, cols, mines, no_guess != 0)};
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void ms_game_free(ms_game* game) {
+  delete game;
+}
+
+void ms_game_set_seed(ms_game* game, uint64_t seed) {
+  game->game.setSeed(seed);
+}
+
+int ms_game_open(ms_game* game, int r, int c) {
+  try {
+    return game->game.open(r, c);
+  } catch (...) {
+    return MS_ERROR;
+  }
+}
+
+int ms_game_toggle_flag(ms_game* game, int r, int c) {
+  try {
+    return game->game.toggleFlag(r, c);
+  } catch (...) {
+    return MS_ERROR;
+  }
+}
+
+int ms_game_status(const ms_game* game) {
+  return game->game.status();
+}
+
+int ms_game_rows(const ms_game* game) {
+  return game->game.board().rows();
+}
+
+int ms_game_cols(const ms_game* game) {
+  return game->game.board().cols();
+}
+
+int ms_game_mines(const ms_game* game) {
+  return game->game.board().mines();
+}
+
+int ms_game_opened(const ms_game* game) {
+  return game->game.board().openedCount();
+}
+
+int ms_game_flags(const ms_game* game) {
+  return game->game.board().flagCount();
+}
+
+uint64_t ms_game_seed(const ms_game* game) {
+  return game->game.board().seed();
+}
+
+int ms_game_cell(const ms_game* game, int r, int c) {
+  const Board& board = game->game.board();
+  return board.inBounds(r, c) ? board.display(r, c) : -1;
+}
+
+void ms_game_cells(const ms_game* game, unsigned char* cells) {
+  const Board& board = game->game.board();
+  for (int r = 1; r <= board.rows(); r++)
+    for (int c = 1; c <= board.cols(); c++)
+      *cells++ = board.display(r, c);
+}
+
+size_t ms_game_save(const ms_game* game, unsigned char* buffer, size_t size) {
+  std::vector<unsigned char> data;
+  try {
+    game->game.save(data);
+  } catch (...) {
+    return 0;
+  }
+  if (data.size() <= size)
+    memcpy(buffer, data.data(), data.size());
+  return data.size();
+}
+
+ms_game* ms_game_load(const unsigned char* data, size_t size) {
+  try {
+    ms_game* game = new ms_game{Game(1, 1, 0)};
+    if (game->game.load(data, size))
+      return game;
+    delete game;
+  } catch (...) {
+  }
+  return nullptr;
+}
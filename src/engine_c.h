@@ -0,0 +1,68 @@
+#ifndef ENGINE_C_H
+#define ENGINE_C_H
+#include <stddef.h>
+#include <stdint.h>
+
+/* The C ABI of libminesweeper, for foreign function interfaces. It wraps the
+ * Game class of engine.h: an ms_game is one game, coordinates are 1-based,
+ * and separate games may be used from separate threads at once. */
+
+#ifndef MINESWEEPER_API
+#ifdef _WIN32
+#define MINESWEEPER_API
+#else
+#define MINESWEEPER_API __attribute__((visibility("default")))
+#endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* MS_ERROR: memory ran out; the game is left as it was before the call or,
+ * at worst, partly updated, and should be freed. */
+enum { MS_PLAYING = 0, MS_WON = 1, MS_LOST = 2, MS_ERROR = -1 };
+
+typedef struct ms_game ms_game;
+
+/* NULL if the size is invalid (no mines, no room for them and a free first
+ * click, or more than 1 << 24 cells) or memory runs out. */
+MINESWEEPER_API ms_game* ms_game_new(int rows, int cols, int mines,
+                                     int no_guess);
+MINESWEEPER_API void ms_game_free(ms_game* game);
+
+/* Seed for the board generated by the first ms_game_open(). */
+MINESWEEPER_API void ms_game_set_seed(ms_game* game, uint64_t seed);
+
+/* Opens or chords a cell; returns the game status afterwards, or MS_ERROR. */
+MINESWEEPER_API int ms_game_open(ms_game* game, int r, int c);
+/* 1 if the flag was toggled, 0 if the cell could not be flagged, or
+ * MS_ERROR. */
+MINESWEEPER_API int ms_game_toggle_flag(ms_game* game, int r, int c);
+MINESWEEPER_API int ms_game_status(const ms_game* game);
+
+MINESWEEPER_API int ms_game_rows(const ms_game* game);
+MINESWEEPER_API int ms_game_cols(const ms_game* game);
+MINESWEEPER_API int ms_game_mines(const ms_game* game);
+MINESWEEPER_API int ms_game_opened(const ms_game* game);
+MINESWEEPER_API int ms_game_flags(const ms_game* game);
+MINESWEEPER_API uint64_t ms_game_seed(const ms_game* game);
+
+/* What a player sees: 0-8 numbers, 9 hidden, 10 flag, 11 mine, 12 wrong
+ * flag; -1 outside the board. */
+MINESWEEPER_API int ms_game_cell(const ms_game* game, int r, int c);
+/* Copies every cell, row by row, into `cells` (rows * cols bytes). */
+MINESWEEPER_API void ms_game_cells(const ms_game* game, unsigned char* cells);
+
+/* Writes the save file encoding into `buffer` if it fits in `size` bytes and
+ * returns its length either way (0 if memory runs out). */
+MINESWEEPER_API size_t ms_game_save(const ms_game* game, unsigned char* buffer,
+                                    size_t size);
+/* NULL if the data is not a valid save. */
+MINESWEEPER_API ms_game* ms_game_load(const unsigned char* data, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,133 +1,308 @@
 #include "game_controller.h"
 #include <algorithm>
-#include <chrono>
-#include <random>
+#include <vector>
+#include "bitboard.h"
+#include "metrics.h"
 
-const int dr[8] = {-1, -1, -1, 0, 0, 1, 1, 1};
-const int dc[8] = {-1, 0, 1, -1, 1, -1, 0, 1};
-
-std::mt19937_64 rng(
-    std::chrono::steady_clock::now().time_since_epoch().count());
+static void neighbourOffsets(const GameState& state, int offset[8]) {
+  int stride = state.stride;
+  int offsets[8] = {-stride - 1, -stride, -stride + 1, -1,
+                    1,           stride - 1, stride,  stride + 1};
+  std::copy(offsets, offsets + 8, offset);
+}
 
 void initBoard(GameState& state, int rows, int cols, int bombCount) {
   state.rows = rows;
   state.cols = cols;
+  state.stride = cols + 2;
   state.elapsedTime = 0;
   state.bombCount = bombCount;
+  state.seed = 0;
+  state.rngKind = RNG_XOSHIRO;
+  state.symmetry = -1;
+  state.noGuess = false;
+  state.openedCount = 0;
+  state.flagCount = 0;
   state.generated = false;
 
-  for (int r = 0; r <= rows + 1; r++) {
-    for (int c = 0; c <= cols + 1; c++) {
-      state.board[r][c] = 0;
-      state.display[r][c] = 9;
-    }
+  state.cells.assign((size_t)(rows + 2) * state.stride, 0);
+  std::fill(state.cells.begin(), state.cells.begin() + state.stride,
+            CELL_OPENED);
+  std::fill(state.cells.end() - state.stride, state.cells.end(), CELL_OPENED);
+  for (int r = 1; r <= rows; r++) {
+    state.cells[cellIndex(state, r, 0)] = CELL_OPENED;
+    state.cells[cellIndex(state, r, cols + 1)] = CELL_OPENED;
   }
 }
 
 void genBoard(GameState& state, int r, int c) {
-  int* bombCandidate = new int[state.rows * state.cols - 1];
+  genBoard(state, r, c, randomSeed());
+}
 
-  for (int i = 0, p = 0; i < state.rows * state.cols; i++)
-    if (i != (r - 1) * state.cols + c - 1)
-      bombCandidate[p++] = i;
+void genBoard(GameState& state, int r, int c, uint64_t seed, RngKind kind) {
+  static thread_local Rng rng;
+  static thread_local MineBitboard mines;
+  seedRng(rng, seed, kind);
+  initBitboard(mines, state.rows, state.cols);
 
-  std::shuffle(bombCandidate, bombCandidate + state.rows * state.cols - 1, rng);
+  // The clicked cell is never a mine; no-guess boards also keep its
+  // neighbours free so that the first click always opens an area.
+  long excluded[9];
+  int excludedCount = 0;
+  int radius = state.noGuess &&
+                       (long)state.rows * state.cols - 9 >= state.bombCount
+                   ? 1
+                   : 0;
+  for (int er = r - radius; er <= r + radius; er++)
+    for (int ec = c - radius; ec <= c + radius; ec++)
+      if (inBound(state, er, ec))
+        excluded[excludedCount++] = (long)(er - 1) * state.cols + ec - 1;
 
-  for (int i = 0; i < state.bombCount; i++)
-    state.board[bombCandidate[i] / state.cols + 1]
-               [bombCandidate[i] % state.cols + 1] = 1;
+  // Floyd's sampling over the remaining cells: every step adds exactly one
+  // mine, so the work is O(bombCount) and the bitboard itself serves as the
+  // set of already chosen cells. Candidate indices skip the excluded cells,
+  // which are in increasing order.
+  auto candidateCell = [&](long pick) {
+    for (int i = 0; i < excludedCount; i++)
+      pick += pick >= excluded[i];
+    return pick;
+  };
+  long candidates = (long)state.rows * state.cols - excludedCount;
+  for (long j = candidates - state.bombCount; j < candidates; j++) {
+    long pick = candidateCell(randomBelow(rng, j + 1));
+    if (testMineBit(mines, pick / state.cols + 1, pick % state.cols + 1))
+      pick = candidateCell(j);
+    setMineBit(mines, pick / state.cols + 1, pick % state.cols + 1);
+  }
+
+  applyBitboard(mines, state);
+  state.seed = seed;
+  state.rngKind = kind;
+  state.symmetry = -1;
   state.generated = true;
 }
 
+bool validSymmetry(const GameState& state, int symmetry) {
+  return symmetry >= 0 && symmetry < BOARD_SYMMETRIES &&
+         (symmetry < 4 || state.rows == state.cols);
+}
+
+void applySymmetry(const GameState& state, int symmetry, int& r, int& c) {
+  if (symmetry & 4)
+    std::swap(r, c);
+  if (symmetry & 1)
+    r = state.rows + 1 - r;
+  if (symmetry & 2)
+    c = state.cols + 1 - c;
+}
+
+void moveBoard(const GameState& from, GameState& to, int r, int c,
+               int symmetry) {
+  static thread_local MineBitboard mines;
+  static thread_local std::vector<int> rowTo, colTo;
+  int rows = to.rows, cols = to.cols;
+  initBitboard(mines, rows, cols);
+
+  // The symmetry and the shift act on rows and columns separately, so where
+  // every source row and column lands is worked out once; with the transpose
+  // a source row picks the destination column and the other way round.
+  int centreR = (rows + 1) / 2, centreC = (cols + 1) / 2;
+  applySymmetry(to, symmetry, centreR, centreC);
+  int shiftR = r - centreR + rows, shiftC = c - centreC + cols;
+  bool transpose = symmetry & 4;
+  rowTo.resize(rows + 1);
+  colTo.resize(cols + 1);
+  for (int i = 1; i <= rows; i++) {
+    int sr = i, sc = 1;
+    applySymmetry(to, symmetry, sr, sc);
+    rowTo[i] = transpose ? (sc - 1 + shiftC) % cols + 1
+                         : (sr - 1 + shiftR) % rows + 1;
+  }
+  for (int j = 1; j <= cols; j++) {
+    int sr = 1, sc = j;
+    applySymmetry(to, symmetry, sr, sc);
+    colTo[j] = transpose ? (sr - 1 + shiftR) % rows + 1
+                         : (sc - 1 + shiftC) % cols + 1;
+  }
+
+  // Branch-free: a quarter of the cells can be mines.
+  uint64_t* bits = mines.bits.data();
+  for (int mr = 1; mr <= rows; mr++) {
+    const unsigned char* row = &from.cells[cellIndex(from, mr, 0)];
+    for (int mc = 1; mc <= cols; mc++) {
+      uint64_t mine = row[mc] >> 4 & 1;
+      int dr = transpose ? colTo[mc] : rowTo[mr];
+      int dc = transpose ? rowTo[mr] : colTo[mc];
+      bits[(size_t)dr * mines.words + (dc >> 6)] |= mine << (dc & 63);
+    }
+  }
+
+  applyBitboard(mines, to);
+  to.seed = from.seed;
+  to.rngKind = from.rngKind;
+  to.symmetry = symmetry;
+  to.generated = true;
+}
+
+void placeBoard(GameState& state,
+                int r,
+                int c,
+                uint64_t seed,
+                RngKind kind,
+                int symmetry) {
+  static thread_local GameState centred;
+  initBoard(centred, state.rows, state.cols, state.bombCount);
+  centred.noGuess = state.noGuess;
+  genBoard(centred, (state.rows + 1) / 2, (state.cols + 1) / 2, seed, kind);
+  moveBoard(centred, state, r, c, symmetry);
+}
+
 bool inBound(const GameState& state, int r, int c) {
   return r > 0 && c > 0 && r <= state.rows && c <= state.cols;
 }
 
-int updateDisplayPosition(GameState& state, int r, int c) {
-  if (state.board[r][c] == 1)
+static int revealIndex(GameState& state, int index) {
+  unsigned char& cell = state.cells[index];
+  if (cell & CELL_MINE)
     return -1;
-  int count = 0;
-  for (int i = 0; i < 8; i++)
-    count += state.board[r + dr[i]][c + dc[i]];
-  state.display[r][c] = count;
-  return count != 0;
+  if (cell & CELL_FLAG)
+    state.flagCount--;
+  if (!(cell & CELL_OPENED))
+    state.openedCount++;
+  cell = (cell & ~CELL_FLAG) | CELL_OPENED;
+  return (cell & CELL_COUNT) != 0;
+}
+
+int updateDisplayPosition(GameState& state, int r, int c) {
+  return revealIndex(state, cellIndex(state, r, c));
 }
 
-bool openPosition(GameState& state, int r, int c) {
+static bool revealCell(GameState& state,
+                       int index,
+                       std::vector<CellPos>* opened) {
+  int updateResult = revealIndex(state, index);
+  if (updateResult == -1) {
+    unsigned char& cell = state.cells[index];
+    if (cell & CELL_FLAG)
+      state.flagCount--;
+    cell = (cell & ~CELL_FLAG) | CELL_OPENED;
+    return false;
+  }
+  if (opened)
+    opened->push_back({index / state.stride, index % state.stride});
+  if (updateResult == 0)
+    state.work.push_back(index);
+  return true;
+}
+
+static bool openCells(GameState& state,
+                      int r,
+                      int c,
+                      std::vector<CellPos>* opened) {
   if (!inBound(state, r, c))
     return true;
 
-  int stack[MAX_M * MAX_N + 10][2];
-  int sTop = 0;
+  // Cells are revealed as soon as they are discovered, so the opened bit
+  // doubles as the "already queued" mark and only zero cells are ever pushed,
+  // each of them once. The border ring is marked as opened, which stops every
+  // scan without explicit bounds checks.
+  std::vector<int>& zeros = state.work;
+  zeros.clear();
 
-  if (state.display[r][c] <= 8) {
+  std::vector<unsigned char>& cells = state.cells;
+  int index = cellIndex(state, r, c);
+  int offset[8];
+  neighbourOffsets(state, offset);
+
+  if (cells[index] & CELL_OPENED) {
     int count = 0;
     for (int i = 0; i < 8; i++)
-      count += state.display[r + dr[i]][c + dc[i]] == 10;
-    if (count == state.display[r][c]) {
-      for (int i = 0; i < 8; i++)
-        if (state.display[r + dr[i]][c + dc[i]] == 9 &&
-            state.board[r + dr[i]][c + dc[i]]) {
-          return false;
-        } else if (state.display[r + dr[i]][c + dc[i]] == 9) {
-          stack[sTop][0] = r + dr[i];
-          stack[sTop++][1] = c + dc[i];
-        }
-    }
+      count += (cells[index + offset[i]] & (CELL_OPENED | CELL_FLAG)) ==
+               CELL_FLAG;
+    if (count != (cells[index] & CELL_COUNT))
+      return true;
+    for (int i = 0; i < 8; i++)
+      if ((cells[index + offset[i]] &
+           (CELL_OPENED | CELL_FLAG | CELL_MINE)) == CELL_MINE)
+        return false;
+    for (int i = 0; i < 8; i++)
+      if (!(cells[index + offset[i]] & (CELL_OPENED | CELL_FLAG)))
+        revealCell(state, index + offset[i], opened);
+  } else if (!revealCell(state, index, opened)) {
+    return false;
   }
 
-  stack[sTop][0] = r;
-  stack[sTop++][1] = c;
-
-  while (sTop > 0) {
-    int sR = stack[--sTop][0];
-    int sC = stack[sTop][1];
+  int stride = state.stride;
+  while (!zeros.empty()) {
+    int zero = zeros.back();
+    zeros.pop_back();
 
-    if (state.display[sR][sC] <= 8)
-      continue;
-
-    int updateResult = updateDisplayPosition(state, sR, sC);
-
-    if (updateResult == -1) {
-      state.display[sR][sC] = 11;
-      return false;
+    // Neighbours of a zero cell are never mines, so the span is grown to
+    // both sides until it ends on a number or an already opened cell.
+    size_t spanZeros = zeros.size();
+    int left = zero, right = zero;
+    while (!(cells[left - 1] & CELL_OPENED)) {
+      revealCell(state, --left, opened);
+      if (zeros.size() == spanZeros)
+        break;
+      zeros.pop_back();
     }
-
-    if (updateResult != 0)
-      continue;
-
-    for (int i = 0; i < 8; i++) {
-      if (inBound(state, sR + dr[i], sC + dc[i]) &&
-          state.display[sR + dr[i]][sC + dc[i]] > 8) {
-        stack[sTop][0] = sR + dr[i];
-        stack[sTop++][1] = sC + dc[i];
-      }
+    while (!(cells[right + 1] & CELL_OPENED)) {
+      revealCell(state, ++right, opened);
+      if (zeros.size() == spanZeros)
+        break;
+      zeros.pop_back();
     }
+
+    if ((cells[left] & CELL_COUNT) == 0)
+      left--;
+    if ((cells[right] & CELL_COUNT) == 0)
+      right++;
+    for (int row = -stride; row <= stride; row += 2 * stride)
+      for (int n = left + row; n <= right + row; n++)
+        if (!(cells[n] & CELL_OPENED))
+          revealCell(state, n, opened);
   }
 
   return true;
 }
 
+bool openPosition(GameState& state,
+                  int r,
+                  int c,
+                  std::vector<CellPos>* opened) {
+  uint64_t start = metricsClock();
+  int openedBefore = state.openedCount;
+  bool alive = openCells(state, r, c, opened);
+  recordElapsed(METRIC_OPEN_TIME, start);
+  recordMetric(METRIC_OPEN_CELLS, state.openedCount - openedBefore);
+  return alive;
+}
+
 void toggleFlagPosition(GameState& state, int r, int c) {
-  if (!inBound(state, r, c) || state.display[r][c] <= 8)
+  if (!inBound(state, r, c))
     return;
-  state.display[r][c] = state.display[r][c] == 9 ? 10 : 9;
+  unsigned char& cell = state.cells[cellIndex(state, r, c)];
+  if (cell & CELL_OPENED)
+    return;
+  cell ^= CELL_FLAG;
+  state.flagCount += cell & CELL_FLAG ? 1 : -1;
 }
 
 void openAllBomb(GameState& state) {
   for (int r = 1; r <= state.rows; r++)
-    for (int c = 1; c <= state.cols; c++)
-      if (state.board[r][c]) {
-        if (state.display[r][c] != 10)
-          state.display[r][c] = 11;
-      } else if (state.display[r][c] == 10)
-        state.display[r][c] = 12;
+    for (int c = 1; c <= state.cols; c++) {
+      unsigned char& cell = state.cells[cellIndex(state, r, c)];
+      if (cell & CELL_MINE) {
+        if (!(cell & CELL_FLAG))
+          cell |= CELL_OPENED;
+      } else if ((cell & (CELL_FLAG | CELL_OPENED)) == CELL_FLAG) {
+        cell |= CELL_OPENED;
+        state.flagCount--;
+      }
+    }
 }
 
 bool isWinState(GameState& state) {
-  for (int r = 1; r <= state.rows; r++)
-    for (int c = 1; c <= state.cols; c++)
-      if (!state.board[r][c] && state.display[r][c] > 8)
-        return false;
-  return true;
+  return state.openedCount == state.rows * state.cols - state.bombCount;
 }
@@ -1,22 +1,96 @@
 #ifndef GAME_CONTROLLER_H
 #define GAME_CONTROLLER_H
+#include <stdint.h>
+#include <vector>
+#include "rng.h"
 
-const int MAX_M = 120;
-const int MAX_N = 120;
+// Every cell is one byte: the low nibble holds the number of neighbouring
+// mines, the high bits hold the mine/opened/flag state.
+const unsigned char CELL_COUNT = 0x0f;
+const unsigned char CELL_MINE = 0x10;
+const unsigned char CELL_OPENED = 0x20;
+const unsigned char CELL_FLAG = 0x40;
 
 struct GameState_s {
-  bool board[MAX_M][MAX_N];
-  int display[MAX_M][MAX_N];
-  int rows, cols, bombCount, elapsedTime;
+  // (rows + 2) x (cols + 2) cells stored row by row. The outer ring is never
+  // played and is marked as opened so neighbour walks need no bounds checks.
+  std::vector<unsigned char> cells;
+  std::vector<int> work;
+  int rows, cols, stride, bombCount, elapsedTime;
+  int openedCount, flagCount;
+  // genBoard(state, r, c, seed, rngKind) rebuilds the same minefield.
+  uint64_t seed;
+  int rngKind;
+  // -1 if genBoard() placed the mines around the first click, otherwise the
+  // board was pooled: generated around the centre cell and moved onto the
+  // first click with this symmetry (see placeBoard()).
+  int symmetry;
+  // Set for no-guess games: genBoard also keeps the first click's neighbours
+  // free of mines.
+  bool noGuess;
   bool generated;
 };
 typedef struct GameState_s GameState;
 
+struct CellPos {
+  int r, c;
+};
+
+inline int cellIndex(const GameState& state, int r, int c) {
+  return r * state.stride + c;
+}
+
+inline bool isMine(const GameState& state, int r, int c) {
+  return state.cells[cellIndex(state, r, c)] & CELL_MINE;
+}
+
+// 0-8: numbers; 9: not yet opened; 10: flag; 11: bomb; 12: wrong flag
+inline int displayAt(const GameState& state, int r, int c) {
+  unsigned char cell = state.cells[cellIndex(state, r, c)];
+  if (cell & CELL_OPENED) {
+    if (cell & CELL_MINE)
+      return 11;
+    if (cell & CELL_FLAG)
+      return 12;
+    return cell & CELL_COUNT;
+  }
+  return cell & CELL_FLAG ? 10 : 9;
+}
+
 void initBoard(GameState& state, int rows, int cols, int bombCount);
 void genBoard(GameState& state, int r, int c);
+void genBoard(GameState& state,
+              int r,
+              int c,
+              uint64_t seed,
+              RngKind kind = RNG_XOSHIRO);
+// A pooled board is generated around the centre cell, then moved so that the
+// first click (r, c) gets what the centre had: symmetry bit 2 transposes
+// (square boards only), bits 0 and 1 mirror the rows and the columns, and a
+// cyclic shift takes the centre's image onto (r, c). Mines keep their count
+// and the shift keeps the layout uniform among those leaving (r, c) free.
+const int BOARD_SYMMETRIES = 8;
+bool validSymmetry(const GameState& state, int symmetry);
+// Where the symmetry alone takes (r, c).
+void applySymmetry(const GameState& state, int symmetry, int& r, int& c);
+// Writes the mines of `from`, a board generated around its centre, into `to`
+// (same size, flags kept) moved onto (r, c).
+void moveBoard(const GameState& from, GameState& to, int r, int c,
+               int symmetry);
+// genBoard() around the centre cell, then moveBoard(): rebuilds a board that
+// records state.symmetry >= 0.
+void placeBoard(GameState& state,
+                int r,
+                int c,
+                uint64_t seed,
+                RngKind kind,
+                int symmetry);
 bool inBound(const GameState& state, int r, int c);
 int updateDisplayPosition(GameState& state, int r, int c);
-bool openPosition(GameState& state, int r, int c);
+bool openPosition(GameState& state,
+                  int r,
+                  int c,
+                  std::vector<CellPos>* opened = nullptr);
 void toggleFlagPosition(GameState& state, int r, int c);
 void openAllBomb(GameState& state);
 bool isWinState(GameState& state);
@@ -0,0 +1,370 @@
+#include "highscores.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include "savefile.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char HIGHSCORES_FILE[] = "highscores.dat";
+static const char HIGHSCORES_LOCK[] = "highscores.lock";
+static const char HIGHSCORES_MAGIC[4] = {'M', 'S', 'H', 'S'};
+const uint32_t HIGHSCORES_VERSION = 2;
+const size_t HIGHSCORES_HEADER = 8;
+
+// The former stores: int[40][40][40 * 20] holding time + 1, 0 if not won,
+// and version 1 logs, where the last record of a board was its best time.
+static const char LEGACY_FILE[] = "highScores.bin";
+const int LEGACY_ROWS = 40, LEGACY_COLS = 40, LEGACY_MINES = 40 * 20;
+
+struct HighscoreRecord {
+  uint16_t rows, cols;
+  uint32_t mines;
+  int32_t time;
+  uint32_t date;
+};
+
+struct HighscoreRecordV1 {
+  uint16_t rows, cols;
+  uint32_t mines;
+  int32_t time;
+};
+
+static_assert(sizeof(HighscoreRecord) == 16, "records are written raw");
+static_assert(sizeof(HighscoreRecordV1) == 12, "records are written raw");
+
+// The lock has a file of its own: compaction renames a new highscores.dat
+// into place, and a lock on the old one would no longer exclude anyone.
+// Returns -1 if the lock cannot be had, in which case the access goes ahead
+// unlocked as before.
+static int lockLeaderboard(bool exclusive) {
+#ifdef _WIN32
+  int fd = _open(HIGHSCORES_LOCK, _O_RDWR | _O_CREAT | _O_BINARY,
+                 _S_IREAD | _S_IWRITE);
+  if (fd < 0)
+    return -1;
+  OVERLAPPED overlapped = {};
+  if (!LockFileEx((HANDLE)_get_osfhandle(fd),
+                  exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, 1, 0,
+                  &overlapped)) {
+    _close(fd);
+    return -1;
+  }
+  return fd;
+#else
+  int fd = open(HIGHSCORES_LOCK, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+  if (fd < 0)
+    return -1;
+  while (flock(fd, exclusive ? LOCK_EX : LOCK_SH) != 0)
+    if (errno != EINTR) {
+      close(fd);
+      return -1;
+    }
+  return fd;
+#endif
+}
+
+static void unlockLeaderboard(int fd) {
+  if (fd < 0)
+    return;
+#ifdef _WIN32
+  OVERLAPPED overlapped = {};
+  UnlockFileEx((HANDLE)_get_osfhandle(fd), 0, 1, 0, &overlapped);
+  _close(fd);
+#else
+  close(fd);
+#endif
+}
+
+static uint64_t boardKey(const HighscoreRecord& record) {
+  return (uint64_t)record.rows << 48 | (uint64_t)record.cols << 32 |
+         record.mines;
+}
+
+static void importLegacy(std::vector<HighscoreRecord>& log) {
+  std::ifstream file(LEGACY_FILE, std::ios::binary);
+  if (!file.is_open())
+    return;
+
+  std::vector<int> times(LEGACY_MINES);
+  for (int r = 0; r < LEGACY_ROWS; r++)
+    for (int c = 0; c < LEGACY_COLS; c++) {
+      if (!file.read((char*)times.data(), times.size() * sizeof(int)))
+        return;
+      for (int m = 0; m < LEGACY_MINES; m++)
+        if (times[m] > 0)
+          log.push_back({(uint16_t)(r + 1), (uint16_t)(c + 1),
+                         (uint32_t)(m + 1), times[m] - 1, 0});
+    }
+}
+
+// Reads every record in the file, oldest first. `rewrite` is set when the
+// file cannot simply be appended to: it is missing, of an older version or
+// ends in a torn record. False for a foreign file, which is left alone.
+static bool readLog(std::vector<HighscoreRecord>& log, bool& rewrite) {
+  log.clear();
+  rewrite = true;
+  std::vector<unsigned char> data;
+  if (!readFile(HIGHSCORES_FILE, data)) {
+    importLegacy(log);
+    return true;
+  }
+
+  uint32_t version;
+  if (data.size() < HIGHSCORES_HEADER ||
+      memcmp(data.data(), HIGHSCORES_MAGIC, sizeof HIGHSCORES_MAGIC))
+    return false;
+  memcpy(&version, data.data() + sizeof HIGHSCORES_MAGIC, sizeof version);
+  const unsigned char* records = data.data() + HIGHSCORES_HEADER;
+  size_t size = data.size() - HIGHSCORES_HEADER;
+
+  if (version == 1) {
+    for (size_t i = 0; i + sizeof(HighscoreRecordV1) <= size;
+         i += sizeof(HighscoreRecordV1)) {
+      HighscoreRecordV1 old;
+      memcpy(&old, records + i, sizeof old);
+      log.push_back({old.rows, old.cols, old.mines, old.time, 0});
+    }
+    return true;
+  }
+  if (version != HIGHSCORES_VERSION)
+    return false;
+  log.resize(size / sizeof(HighscoreRecord));
+  memcpy(log.data(), records, log.size() * sizeof(HighscoreRecord));
+  rewrite = size % sizeof(HighscoreRecord) != 0;
+  return true;
+}
+
+// A leaderboard from records in the order they were written: of equal times
+// the earlier win stays first.
+static void addRecord(std::vector<Highscore>& times,
+                      const HighscoreRecord& record) {
+  auto later = std::upper_bound(
+      times.begin(), times.end(), record.time,
+      [](int time, const Highscore& other) { return time < other.time; });
+  if (later - times.begin() >= LEADERBOARD_SIZE)
+    return;
+  times.insert(later, {record.time, record.date});
+  if (times.size() > (size_t)LEADERBOARD_SIZE)
+    times.pop_back();
+}
+
+// Which file HIGHSCORES_FILE is: compaction renames a new one into place,
+// while appends keep the file and only make it longer.
+struct LogFile {
+  uint64_t id;
+  uint64_t size;
+};
+
+static bool statLog(LogFile& file) {
+#ifdef _WIN32
+  HANDLE handle =
+      CreateFileA(HIGHSCORES_FILE, 0,
+                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                  nullptr, OPEN_EXISTING, 0, nullptr);
+  if (handle == INVALID_HANDLE_VALUE)
+    return false;
+  BY_HANDLE_FILE_INFORMATION info;
+  bool found = GetFileInformationByHandle(handle, &info);
+  CloseHandle(handle);
+  if (!found)
+    return false;
+  file.id = (uint64_t)info.nFileIndexHigh << 32 | info.nFileIndexLow;
+  file.size = (uint64_t)info.nFileSizeHigh << 32 | info.nFileSizeLow;
+  return true;
+#else
+  struct stat info;
+  if (stat(HIGHSCORES_FILE, &info) != 0)
+    return false;
+  file.id = (uint64_t)info.st_dev << 32 ^ info.st_ino;
+  file.size = info.st_size;
+  return true;
+#endif
+}
+
+// This process's index of the leaderboards, brought up to date under the
+// lock before every use. Records appended since the last look are read on
+// their own, so a lookup costs as much as what other processes added since;
+// only a new file (compacted, converted or imported) is read in full.
+struct LogIndex {
+  bool valid, present;
+  LogFile file;
+  // Where the next appended record starts, and the records up to there.
+  uint64_t end;
+  size_t records;
+  // The file cannot simply be appended to (see readLog()).
+  bool rewrite;
+  std::map<uint64_t, std::vector<Highscore>> boards;
+};
+
+static std::mutex indexMutex;
+static LogIndex logIndex;
+
+static bool readAppended(LogIndex& index, uint64_t size) {
+  size_t count = (size - index.end) / sizeof(HighscoreRecord);
+  if (!count)
+    return true;
+  std::vector<HighscoreRecord> records(count);
+  FILE* file = fopen(HIGHSCORES_FILE, "rb");
+  bool read = file && fseek(file, (long)index.end, SEEK_SET) == 0 &&
+              fread(records.data(), sizeof(HighscoreRecord), count, file) ==
+                  count;
+  if (file)
+    fclose(file);
+  if (!read)
+    return false;
+  for (const HighscoreRecord& record : records)
+    addRecord(index.boards[boardKey(record)], record);
+  index.end += count * sizeof(HighscoreRecord);
+  index.records += count;
+  return true;
+}
+
+// False for a foreign file.
+static bool refreshIndex() {
+  LogIndex& index = logIndex;
+  LogFile file;
+  bool present = statLog(file);
+  if (index.valid && present == index.present &&
+      (!present || file.id == index.file.id)) {
+    if (!present || file.size == index.file.size)
+      return true;
+    if (!index.rewrite && file.size > index.end &&
+        readAppended(index, file.size)) {
+      // A torn record at the end must not be appended to.
+      index.rewrite = index.end != file.size;
+      index.file = file;
+      return true;
+    }
+  }
+
+  std::vector<HighscoreRecord> log;
+  index.valid = false;
+  index.boards.clear();
+  if (!readLog(log, index.rewrite))
+    return false;
+  for (const HighscoreRecord& record : log)
+    addRecord(index.boards[boardKey(record)], record);
+  index.valid = true;
+  index.present = present;
+  index.file = file;
+  index.end = HIGHSCORES_HEADER + log.size() * sizeof(HighscoreRecord);
+  index.records = log.size();
+  return true;
+}
+
+static bool writeLog(const LogIndex& index, const HighscoreRecord& record) {
+  std::vector<HighscoreRecord> log;
+  for (const auto& board : index.boards)
+    for (const Highscore& highscore : board.second)
+      log.push_back({(uint16_t)(board.first >> 48),
+                     (uint16_t)(board.first >> 32), (uint32_t)board.first,
+                     highscore.time, (uint32_t)highscore.date});
+  log.push_back(record);
+
+  std::vector<unsigned char> data(HIGHSCORES_MAGIC,
+                                  HIGHSCORES_MAGIC + sizeof HIGHSCORES_MAGIC);
+  data.resize(HIGHSCORES_HEADER + log.size() * sizeof(HighscoreRecord));
+  memcpy(data.data() + sizeof HIGHSCORES_MAGIC, &HIGHSCORES_VERSION,
+         sizeof HIGHSCORES_VERSION);
+  memcpy(data.data() + HIGHSCORES_HEADER, log.data(),
+         log.size() * sizeof(HighscoreRecord));
+  return writeFileAtomic(HIGHSCORES_FILE, data);
+}
+
+void getLeaderboard(int rows, int cols, int mines,
+                    std::vector<Highscore>& times) {
+  HighscoreRecord board = {(uint16_t)rows, (uint16_t)cols, (uint32_t)mines, 0,
+                           0};
+  std::lock_guard<std::mutex> guard(indexMutex);
+  int lock = lockLeaderboard(false);
+  bool read = refreshIndex();
+  unlockLeaderboard(lock);
+
+  times.clear();
+  auto found = logIndex.boards.find(boardKey(board));
+  if (read && found != logIndex.boards.end())
+    times = found->second;
+}
+
+int getHighscore(int rows, int cols, int mines) {
+  std::vector<Highscore> times;
+  getLeaderboard(rows, cols, mines, times);
+  return times.empty() ? -1 : times[0].time;
+}
+
+int setHighscore(int rows, int cols, int mines, int time) {
+  HighscoreRecord record = {(uint16_t)rows, (uint16_t)cols, (uint32_t)mines,
+                            time, (uint32_t)::time(nullptr)};
+  int rank = 0;
+  std::lock_guard<std::mutex> guard(indexMutex);
+  int lock = lockLeaderboard(true);
+  if (refreshIndex()) {
+    const std::vector<Highscore>& times = logIndex.boards[boardKey(record)];
+    int faster = 0;
+    for (const Highscore& other : times)
+      faster += other.time <= time;
+
+    size_t live = 0;
+    for (const auto& board : logIndex.boards)
+      live += board.second.size();
+    if (faster < LEADERBOARD_SIZE) {
+      rank = faster + 1;
+      // Compact once stale records outnumber live ones.
+      if (logIndex.rewrite || logIndex.records + 1 > 2 * live + 16) {
+        writeLog(logIndex, record);
+      } else if (FILE* file = fopen(HIGHSCORES_FILE, "ab")) {
+        fwrite(&record, sizeof record, 1, file);
+        fclose(file);
+      }
+      // Picks up the appended record, or reads the compacted file.
+      refreshIndex();
+    }
+  }
+  unlockLeaderboard(lock);
+  return rank;
+}
+
+void printLeaderboards() {
+  std::lock_guard<std::mutex> guard(indexMutex);
+  int lock = lockLeaderboard(false);
+  bool read = refreshIndex();
+  unlockLeaderboard(lock);
+  if (!read) {
+    fprintf(stderr, "%s: not a leaderboard\n", HIGHSCORES_FILE);
+    return;
+  }
+
+  bool first = true;
+  for (const auto& board : logIndex.boards) {
+    if (board.second.empty())
+      continue;
+    printf("%s%dx%d, %u mines\n", first ? "" : "\n",
+           (int)(uint16_t)(board.first >> 48),
+           (int)(uint16_t)(board.first >> 32), (uint32_t)board.first);
+    first = false;
+    int rank = 0;
+    for (const Highscore& highscore : board.second) {
+      char date[32] = "-";
+      time_t when = highscore.date;
+      if (when)
+        strftime(date, sizeof date, "%Y-%m-%d %H:%M", localtime(&when));
+      printf("  %2d. %5ds  %s\n", ++rank, highscore.time, date);
+    }
+  }
+}
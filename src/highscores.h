@@ -0,0 +1,40 @@
+#ifndef HIGHSCORES_H
+#define HIGHSCORES_H
+#include <stdint.h>
+#include <vector>
+
+// The LEADERBOARD_SIZE best times per board (rows, cols, mines), shared by
+// every process started in the same directory. highscores.dat is an
+// append-only log of fixed-size records: a win that makes its board's top
+// times appends one record, and once stale records outnumber live ones the
+// log is rewritten with only the top times. Processes take a lock on
+// highscores.lock around every access, shared to read and exclusive to
+// write, so concurrent wins neither interleave nor overwrite each other, and
+// every lookup sees the other processes' records. Each process keeps the
+// leaderboards indexed by board and only reads what was appended since its
+// last look, so lookups do not slow down as the log grows. Version 1 files
+// (one best time per board) and a legacy highScores.bin array are imported.
+
+const int LEADERBOARD_SIZE = 10;
+
+struct Highscore {
+  int time;
+  // Unix time of the win, 0 if imported from an older format.
+  int64_t date;
+};
+
+// Best time in seconds, or -1 if the board has never been won.
+int getHighscore(int rows, int cols, int mines);
+
+// Records a win. Returns its rank among the board's best times (1 for a new
+// best), or 0 if it did not make the leaderboard and was not recorded.
+int setHighscore(int rows, int cols, int mines, int time);
+
+// The board's best times, fastest first; ties keep the earlier win first.
+void getLeaderboard(int rows, int cols, int mines,
+                    std::vector<Highscore>& times);
+
+// Every board's leaderboard as text, for --leaderboard.
+void printLeaderboards();
+
+#endif
@@ -0,0 +1,269 @@
+#include "journal.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include "savefile.h"
+
+static const char JOURNAL_MAGIC[4] = {'M', 'S', 'J', 'R'};
+// Version 2 added the symmetry of pooled boards; version 1 files still load.
+const uint16_t JOURNAL_VERSION = 2;
+const unsigned char TAG_PLACED = 0x80;
+
+static void putVarint(std::vector<unsigned char>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(value | 0x80);
+    value >>= 7;
+  }
+  out.push_back(value);
+}
+
+static bool getVarint(const unsigned char*& data,
+                      const unsigned char* end,
+                      uint64_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 64 && data < end; shift += 7) {
+    unsigned char byte = *data++;
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if (!(byte & 0x80))
+      return true;
+  }
+  return false;
+}
+
+static uint64_t zigzag(int64_t value) {
+  return (uint64_t)value << 1 ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value) {
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+void startJournal(Journal& journal, const GameState& state) {
+  encodeSave(state, journal.initial);
+  journal.events.clear();
+  journal.count = 0;
+  journal.time = 0;
+  journal.r = 1;
+  journal.c = 1;
+}
+
+void recordEvent(Journal& journal, const JournalEvent& event) {
+  std::vector<unsigned char>& out = journal.events;
+  bool placed = event.kind == EVENT_GENERATE && event.symmetry >= 0;
+  out.push_back(event.kind | event.rngKind << 4 | (placed ? TAG_PLACED : 0));
+  putVarint(out, event.time - journal.time);
+  putVarint(out, zigzag(event.r - journal.r));
+  putVarint(out, zigzag(event.c - journal.c));
+  if (event.kind == EVENT_GENERATE)
+    putVarint(out, event.seed);
+  if (placed)
+    putVarint(out, event.symmetry);
+  journal.time = event.time;
+  journal.r = event.r;
+  journal.c = event.c;
+  journal.count++;
+}
+
+bool writeJournal(const Journal& journal, const char* path) {
+  std::vector<unsigned char> data(JOURNAL_MAGIC,
+                                  JOURNAL_MAGIC + sizeof JOURNAL_MAGIC);
+  data.push_back(JOURNAL_VERSION & 0xff);
+  data.push_back(JOURNAL_VERSION >> 8);
+  putVarint(data, journal.initial.size());
+  data.insert(data.end(), journal.initial.begin(), journal.initial.end());
+  putVarint(data, journal.count);
+  data.insert(data.end(), journal.events.begin(), journal.events.end());
+  uint32_t crc = crc32(data.data(), data.size());
+  for (int i = 0; i < 4; i++)
+    data.push_back(crc >> 8 * i & 0xff);
+  return writeFileAtomic(path, data);
+}
+
+bool readJournal(const char* path,
+                 GameState& initial,
+                 std::vector<JournalEvent>& events) {
+  std::vector<unsigned char> data;
+  if (!readFile(path, data) || data.size() < sizeof JOURNAL_MAGIC + 6 ||
+      memcmp(data.data(), JOURNAL_MAGIC, sizeof JOURNAL_MAGIC) ||
+      (data[4] | data[5] << 8) < 1 ||
+      (data[4] | data[5] << 8) > JOURNAL_VERSION)
+    return false;
+  const unsigned char* end = data.data() + data.size() - 4;
+  uint32_t crc = end[0] | end[1] << 8 | end[2] << 16 | (uint32_t)end[3] << 24;
+  if (crc != crc32(data.data(), data.size() - 4))
+    return false;
+
+  const unsigned char* p = data.data() + sizeof JOURNAL_MAGIC + 2;
+  uint64_t initialSize, count;
+  if (!getVarint(p, end, initialSize) || initialSize > (uint64_t)(end - p) ||
+      !decodeSave(p, initialSize, initial))
+    return false;
+  p += initialSize;
+  if (!getVarint(p, end, count) || count > (uint64_t)(end - p))
+    return false;
+
+  JournalEvent event = {EVENT_MOVE, 0, 1, 1, 0, RNG_XOSHIRO, -1};
+  events.clear();
+  events.reserve(count);
+  for (uint64_t i = 0; i < count; i++) {
+    uint64_t dt, dr, dc, symmetry = 0;
+    if (p == end)
+      return false;
+    bool placed = *p & TAG_PLACED;
+    event.kind = *p & 0x0f;
+    event.rngKind = *p++ >> 4 & 0x07;
+    if (event.kind > EVENT_RESUME || (placed && event.kind != EVENT_GENERATE) ||
+        !getVarint(p, end, dt) || !getVarint(p, end, dr) ||
+        !getVarint(p, end, dc) ||
+        (event.kind == EVENT_GENERATE && !getVarint(p, end, event.seed)) ||
+        (placed && (!getVarint(p, end, symmetry) ||
+                    symmetry >= BOARD_SYMMETRIES ||
+                    !validSymmetry(initial, symmetry))))
+      return false;
+    event.symmetry = placed ? (int)symmetry : -1;
+    event.time += dt;
+    event.r += unzigzag(dr);
+    event.c += unzigzag(dc);
+    if (!inBound(initial, event.r, event.c))
+      return false;
+    events.push_back(event);
+  }
+  return p == end;
+}
+
+bool applyEvent(GameState& state, const JournalEvent& event) {
+  if (event.kind == EVENT_GENERATE && event.symmetry >= 0)
+    placeBoard(state, event.r, event.c, event.seed, (RngKind)event.rngKind,
+               event.symmetry);
+  else if (event.kind == EVENT_GENERATE)
+    genBoard(state, event.r, event.c, event.seed, (RngKind)event.rngKind);
+  else if (event.kind == EVENT_FLAG)
+    toggleFlagPosition(state, event.r, event.c);
+  else if (event.kind == EVENT_OPEN || event.kind == EVENT_CHORD)
+    return openPosition(state, event.r, event.c);
+  return true;
+}
+
+static bool changesBoard(const JournalEvent& event) {
+  return event.kind != EVENT_MOVE && event.kind != EVENT_PAUSE &&
+         event.kind != EVENT_RESUME;
+}
+
+// Keyframes leave out the scratch space, which can be as large as the board.
+static void addKeyframe(Replay& replay, size_t event, GameState& state) {
+  std::vector<int> work;
+  work.swap(state.work);
+  replay.keyframes.push_back({event, state});
+  work.swap(state.work);
+}
+
+bool loadReplay(const char* path, Replay& replay) {
+  GameState state;
+  if (!readJournal(path, state, replay.events))
+    return false;
+
+  long total = 0;
+  for (const JournalEvent& event : replay.events)
+    total += changesBoard(event);
+  long keyframes =
+      std::max(1L, REPLAY_KEYFRAME_BYTES / (long)state.cells.size());
+  replay.interval = std::max((long)REPLAY_KEYFRAME_INTERVAL,
+                             (total + keyframes - 1) / keyframes);
+
+  replay.keyframes.clear();
+  addKeyframe(replay, 0, state);
+  long changes = 0;
+  for (size_t i = 0; i < replay.events.size(); i++) {
+    if (!changesBoard(replay.events[i]))
+      continue;
+    if (changes++ == replay.interval) {
+      addKeyframe(replay, i, state);
+      changes = 1;
+    }
+    applyEvent(state, replay.events[i]);
+  }
+  return true;
+}
+
+void seekReplay(const Replay& replay, size_t count, GameState& state) {
+  size_t low = 0, high = replay.keyframes.size();
+  while (high - low > 1) {
+    size_t middle = (low + high) / 2;
+    if (replay.keyframes[middle].event <= count)
+      low = middle;
+    else
+      high = middle;
+  }
+  state = replay.keyframes[low].state;
+  for (size_t i = replay.keyframes[low].event;
+       i < count && i < replay.events.size(); i++)
+    applyEvent(state, replay.events[i]);
+}
+
+int64_t replayGameTime(const Replay& replay, size_t count) {
+  const GameState& initial = replay.keyframes[0].state;
+  bool running = initial.generated, paused = false;
+  int64_t total = (int64_t)initial.elapsedTime * 1000, since = 0;
+  for (size_t i = 0; i < count && i < replay.events.size(); i++) {
+    const JournalEvent& event = replay.events[i];
+    if (running && !paused && event.kind == EVENT_PAUSE)
+      total += event.time - since;
+    if (event.kind == EVENT_PAUSE)
+      paused = true;
+    else if (event.kind == EVENT_RESUME)
+      paused = false, since = event.time;
+    else if (event.kind == EVENT_GENERATE)
+      running = true, since = event.time;
+  }
+  if (running && !paused && count > 0)
+    total += replay.events[std::min(count, replay.events.size()) - 1].time -
+             since;
+  return total;
+}
+
+void printReplayReport(const Replay& replay, int64_t at) {
+  std::chrono::steady_clock::time_point start =
+      std::chrono::steady_clock::now();
+  long actions = 0;
+  bool lost = false;
+  GameState state = replay.keyframes[0].state;
+  for (const JournalEvent& event : replay.events) {
+    actions += event.kind == EVENT_OPEN || event.kind == EVENT_CHORD ||
+               event.kind == EVENT_FLAG;
+    lost |= !applyEvent(state, event);
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  int64_t duration = replay.events.empty() ? 0 : replay.events.back().time;
+  printf("board:     %dx%d, %d mines, seed %llu%s\n", state.rows, state.cols,
+         state.bombCount, (unsigned long long)state.seed,
+         state.noGuess ? ", no-guess" : "");
+  printf("events:    %zu (%ld actions), %zu keyframes\n", replay.events.size(),
+         actions, replay.keyframes.size());
+  printf("result:    %s\n", lost                ? "lost"
+                            : isWinState(state) ? "won"
+                                                : "unfinished");
+  printf("game time: %.3f s (%.3f s recorded)\n",
+         replayGameTime(replay, replay.events.size()) / 1000.0,
+         duration / 1000.0);
+  printf("replayed:  %.1f us, %.0fx real time\n", seconds * 1e6,
+         seconds > 0 ? duration / 1000.0 / seconds : 0);
+
+  if (at < 0)
+    return;
+  size_t count = 0;
+  while (count < replay.events.size() && replay.events[count].time <= at)
+    count++;
+  seekReplay(replay, count, state);
+  printf("\nat %.3f s (event %zu, game time %.3f s):\n", at / 1000.0, count,
+         replayGameTime(replay, count) / 1000.0);
+  const char glyphs[] = ".12345678#F*X";
+  for (int r = 1; r <= state.rows; r++) {
+    for (int c = 1; c <= state.cols; c++)
+      putchar(glyphs[displayAt(state, r, c)]);
+    putchar('\n');
+  }
+}
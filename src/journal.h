@@ -0,0 +1,90 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "game_controller.h"
+
+enum JournalEventKind {
+  EVENT_MOVE = 0,
+  EVENT_OPEN = 1,
+  EVENT_FLAG = 2,
+  // Opening a number whose flags are complete.
+  EVENT_CHORD = 3,
+  // genBoard(state, r, c, seed, rngKind) right before the first open, or
+  // placeBoard() for a pooled board (symmetry >= 0).
+  EVENT_GENERATE = 4,
+  EVENT_PAUSE = 5,
+  EVENT_RESUME = 6
+};
+
+struct JournalEvent {
+  int kind;
+  // Milliseconds since the journal was started, pauses included.
+  int64_t time;
+  // Cursor position the event applies to.
+  int r, c;
+  uint64_t seed;
+  int rngKind;
+  int symmetry;
+};
+
+// Every action of one game, recorded from the state it started from (a new
+// board or a resumed save). Each event is a tag byte (kind, rng kind) and
+// varints for the time since the previous event and the zigzagged cursor
+// movement, plus the seed for EVENT_GENERATE (and the symmetry if the tag's
+// high bit is set): a few bytes per action.
+// Files hold "MSJR", a version, the initial state in the save format, the
+// event count, the events and a CRC-32.
+struct Journal {
+  std::vector<unsigned char> initial, events;
+  long count;
+  int64_t time;
+  int r, c;
+};
+
+const char JOURNAL_FILE[] = "last_game.msj";
+
+void startJournal(Journal& journal, const GameState& state);
+void recordEvent(Journal& journal, const JournalEvent& event);
+bool writeJournal(const Journal& journal, const char* path);
+bool readJournal(const char* path,
+                 GameState& initial,
+                 std::vector<JournalEvent>& events);
+
+// Applies one event the way gameLoop does; false once a mine is opened.
+bool applyEvent(GameState& state, const JournalEvent& event);
+
+struct ReplayKeyframe {
+  size_t event;
+  GameState state;
+};
+
+// A journal loaded for seeking: the state before event keyframes[i].event is
+// kept every `interval` board changes, so reaching any event replays at most
+// that many board changes from the nearest keyframe. The interval is
+// REPLAY_KEYFRAME_INTERVAL, or longer on boards so large that the keyframes
+// would take more than REPLAY_KEYFRAME_BYTES.
+struct Replay {
+  std::vector<JournalEvent> events;
+  std::vector<ReplayKeyframe> keyframes;
+  long interval;
+};
+
+const int REPLAY_KEYFRAME_INTERVAL = 64;
+const long REPLAY_KEYFRAME_BYTES = 64L << 20;
+
+bool loadReplay(const char* path, Replay& replay);
+
+// The state after the first `count` events.
+void seekReplay(const Replay& replay, size_t count, GameState& state);
+
+// Game time (pauses and the time before the first open excluded) after the
+// first `count` events, in milliseconds.
+int64_t replayGameTime(const Replay& replay, size_t count);
+
+// Summary of a replay for --replay: result, game time and replay speed, and
+// the board as text at `at` milliseconds unless `at` is negative.
+void printReplayReport(const Replay& replay, int64_t at);
+
+#endif
@@ -0,0 +1,206 @@
+#include "metrics.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include "savefile.h"
+#ifndef _WIN32
+#include <pthread.h>
+#include <signal.h>
+#endif
+
+// Values below 16 get a bucket each; above that every power of two is split
+// into 16 linear sub-buckets, so a bucket is never wider than 1/16 of the
+// values in it and 976 buckets cover the whole uint64_t range.
+static const int SUB_BUCKET_BITS = 4;
+static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+static const int BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+// Counters are updated with relaxed atomics: openPosition() also runs on the
+// simulator's worker threads, and a dump may read while the game records.
+struct Histogram {
+  std::atomic<uint64_t> counts[BUCKET_COUNT];
+  std::atomic<uint64_t> total, sum, min, max;
+};
+
+struct MetricInfo {
+  const char* name;
+  const char* help;
+  double scale;
+};
+
+static const MetricInfo METRIC_INFO[METRIC_COUNT] = {
+    {"input_latency_seconds", "Input event to the flush of the next frame.",
+     1e-9},
+    {"render_seconds", "Time to emit and flush one game frame.", 1e-9},
+    {"render_bytes", "Bytes written for one game frame.", 1},
+    {"open_seconds", "Time spent in one openPosition call.", 1e-9},
+    {"open_cells", "Cells revealed by one openPosition call.", 1},
+};
+
+static Histogram histograms[METRIC_COUNT];
+static std::string dumpPath;
+
+static int bucketOf(uint64_t value) {
+  if (value < (uint64_t)SUB_BUCKETS)
+    return value;
+  int exponent = 63 - __builtin_clzll(value);
+  int shift = exponent - SUB_BUCKET_BITS;
+  return (shift + 1) * SUB_BUCKETS + ((value >> shift) & (SUB_BUCKETS - 1));
+}
+
+// The largest value that falls in `bucket`.
+static uint64_t bucketLimit(int bucket) {
+  if (bucket < SUB_BUCKETS)
+    return bucket;
+  int shift = bucket / SUB_BUCKETS - 1;
+  uint64_t low = (uint64_t)(SUB_BUCKETS + bucket % SUB_BUCKETS) << shift;
+  return low + ((uint64_t)1 << shift) - 1;
+}
+
+void recordMetricValue(Metric metric, uint64_t value) {
+  Histogram& h = histograms[metric];
+  h.counts[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  h.sum.fetch_add(value, std::memory_order_relaxed);
+  // The first value initialises min; racing first values only risk min.
+  if (h.total.fetch_add(1, std::memory_order_relaxed) == 0)
+    h.min.store(value, std::memory_order_relaxed);
+  uint64_t seen = h.min.load(std::memory_order_relaxed);
+  while (value < seen &&
+         !h.min.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+    ;
+  seen = h.max.load(std::memory_order_relaxed);
+  while (value > seen &&
+         !h.max.compare_exchange_weak(seen, value, std::memory_order_relaxed))
+    ;
+}
+
+void summarizeMetric(Metric metric, MetricSummary& summary) {
+  const Histogram& h = histograms[metric];
+  double scale = METRIC_INFO[metric].scale;
+  uint64_t counts[BUCKET_COUNT];
+  uint64_t total = 0;
+  for (int i = 0; i < BUCKET_COUNT; i++)
+    total += counts[i] = h.counts[i].load(std::memory_order_relaxed);
+  summary.count = total;
+  summary.sum = h.sum.load(std::memory_order_relaxed) * scale;
+  summary.min = total ? h.min.load(std::memory_order_relaxed) * scale : 0;
+  summary.max = h.max.load(std::memory_order_relaxed) * scale;
+
+  const double quantiles[] = {0.5, 0.9, 0.99, 0.999};
+  double* results[] = {&summary.p50, &summary.p90, &summary.p99,
+                       &summary.p999};
+  uint64_t seen = 0;
+  int bucket = 0;
+  for (int q = 0; q < 4; q++) {
+    // The rank of the quantile, counting from 1, and never past the max.
+    uint64_t rank = (uint64_t)(quantiles[q] * total + 0.999999);
+    while (bucket < BUCKET_COUNT && seen + counts[bucket] < rank)
+      seen += counts[bucket++];
+    *results[q] = total ? std::min(bucketLimit(bucket) * scale, summary.max)
+                        : 0;
+  }
+}
+
+// Sorted nanoseconds in, microseconds out, for q in [0, 1].
+double percentile(const std::vector<int64_t>& sorted, double q) {
+  if (sorted.empty())
+    return 0;
+  size_t index = std::min(sorted.size() - 1, (size_t)(q * sorted.size()));
+  return sorted[index] / 1000.0;
+}
+
+// Seconds are shown in the unit that keeps them readable.
+static void formatValue(Metric metric, double value, char* out, size_t size) {
+  if (METRIC_INFO[metric].scale == 1)
+    snprintf(out, size, "%.0f", value);
+  else if (value < 1e-3)
+    snprintf(out, size, "%.0fus", value * 1e6);
+  else if (value < 1)
+    snprintf(out, size, "%.1fms", value * 1e3);
+  else
+    snprintf(out, size, "%.2fs", value);
+}
+
+void formatMetricsOverlay(char* line, size_t size) {
+  static const char* const labels[METRIC_COUNT] = {"input", "render", "bytes",
+                                                   "open", "cells"};
+  size_t length = snprintf(line, size, "p50/p99");
+  for (int i = 0; i < METRIC_COUNT && length < size; i++) {
+    MetricSummary summary;
+    summarizeMetric((Metric)i, summary);
+    char p50[16], p99[16];
+    formatValue((Metric)i, summary.p50, p50, sizeof(p50));
+    formatValue((Metric)i, summary.p99, p99, sizeof(p99));
+    length += snprintf(line + length, size - length, "  %s %s/%s", labels[i],
+                       p50, p99);
+  }
+}
+
+std::string formatMetrics(bool json) {
+  std::string out = json ? "{\n" : "";
+  char line[512];
+  for (int i = 0; i < METRIC_COUNT; i++) {
+    MetricSummary s;
+    summarizeMetric((Metric)i, s);
+    const char* name = METRIC_INFO[i].name;
+    if (json) {
+      snprintf(line, sizeof(line),
+               "  \"%s\": {\"count\": %llu, \"sum\": %.9g, \"min\": %.9g, "
+               "\"max\": %.9g, \"p50\": %.9g, \"p90\": %.9g, \"p99\": %.9g, "
+               "\"p999\": %.9g}%s\n",
+               name, (unsigned long long)s.count, s.sum, s.min, s.max, s.p50,
+               s.p90, s.p99, s.p999, i + 1 < METRIC_COUNT ? "," : "");
+    } else {
+      snprintf(line, sizeof(line),
+               "# HELP minesweeper_%s %s\n"
+               "# TYPE minesweeper_%s summary\n"
+               "minesweeper_%s{quantile=\"0.5\"} %.9g\n"
+               "minesweeper_%s{quantile=\"0.9\"} %.9g\n"
+               "minesweeper_%s{quantile=\"0.99\"} %.9g\n"
+               "minesweeper_%s{quantile=\"0.999\"} %.9g\n"
+               "minesweeper_%s_sum %.9g\n"
+               "minesweeper_%s_count %llu\n",
+               name, METRIC_INFO[i].help, name, name, s.p50, name, s.p90,
+               name, s.p99, name, s.p999, name, s.sum, name,
+               (unsigned long long)s.count);
+    }
+    out += line;
+  }
+  if (json)
+    out += "}\n";
+  return out;
+}
+
+bool writeMetrics(const char* path) {
+  size_t length = strlen(path);
+  bool json = length >= 5 && !strcmp(path + length - 5, ".json");
+  std::string text = formatMetrics(json);
+  return writeFileAtomic(path,
+                         std::vector<unsigned char>(text.begin(), text.end()));
+}
+
+static void dumpAtExit() {
+  writeMetrics(dumpPath.c_str());
+}
+
+void dumpMetricsTo(const char* path) {
+  dumpPath = path;
+  atexit(dumpAtExit);
+#ifndef _WIN32
+  // Threads inherit the mask, so only this one ever takes SIGUSR1.
+  sigset_t dumpSignal;
+  sigemptyset(&dumpSignal);
+  sigaddset(&dumpSignal, SIGUSR1);
+  pthread_sigmask(SIG_BLOCK, &dumpSignal, nullptr);
+  std::thread([dumpSignal] {
+    int signal;
+    while (sigwait(&dumpSignal, &signal) == 0)
+      writeMetrics(dumpPath.c_str());
+  }).detach();
+#endif
+}
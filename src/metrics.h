@@ -0,0 +1,81 @@
+#ifndef METRICS_H
+#define METRICS_H
+#include <stdint.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// Latency and size histograms for the UI and the engine. They are compiled in
+// only with -DMINESWEEPER_METRICS (make METRICS=1); otherwise every recording
+// call below is a constant-false branch that the compiler drops, and the
+// clock is never read.
+#ifdef MINESWEEPER_METRICS
+const bool METRICS_ENABLED = true;
+#else
+const bool METRICS_ENABLED = false;
+#endif
+
+enum Metric {
+  // From waitForEvents() reporting input to the flush of the next frame.
+  METRIC_INPUT_LATENCY,
+  // render() from the first byte emitted to the end of the flush.
+  METRIC_RENDER_TIME,
+  METRIC_RENDER_BYTES,
+  // One openPosition() call and the cells it revealed.
+  METRIC_OPEN_TIME,
+  METRIC_OPEN_CELLS,
+  METRIC_COUNT
+};
+
+// Nanoseconds on a monotonic clock; 0 with metrics compiled out.
+inline uint64_t metricsClock() {
+  if (!METRICS_ENABLED)
+    return 0;
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void recordMetricValue(Metric metric, uint64_t value);
+
+inline void recordMetric(Metric metric, uint64_t value) {
+  if (METRICS_ENABLED)
+    recordMetricValue(metric, value);
+}
+
+// Records the time since `start`, taken from metricsClock().
+inline void recordElapsed(Metric metric, uint64_t start) {
+  if (METRICS_ENABLED)
+    recordMetricValue(metric, metricsClock() - start);
+}
+
+// A histogram read back in its base unit (seconds, bytes or cells).
+// Percentiles are accurate to the bucket width, 1/16 of the value.
+struct MetricSummary {
+  uint64_t count;
+  double sum, min, max;
+  double p50, p90, p99, p999;
+};
+
+void summarizeMetric(Metric metric, MetricSummary& summary);
+
+// The q-quantile of nanosecond samples sorted in ascending order, in
+// microseconds; 0 without samples. For reports that keep every sample, such
+// as --simulate and --tournament.
+double percentile(const std::vector<int64_t>& sorted, double q);
+
+// Medians and 99th percentiles of every metric on one line, for the overlay.
+void formatMetricsOverlay(char* line, size_t size);
+
+// Every metric as a JSON object, or as Prometheus text format summaries.
+std::string formatMetrics(bool json);
+
+// JSON if `path` ends in ".json", Prometheus text format otherwise.
+bool writeMetrics(const char* path);
+
+// Writes the metrics to `path` when the process exits and, except on
+// Windows, whenever it receives SIGUSR1. Must be called before any other
+// thread is started, as it blocks SIGUSR1 for a thread of its own to take.
+void dumpMetricsTo(const char* path);
+
+#endif
@@ -1,30 +1,197 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <chrono>
 #include <filesystem>
-#include <fstream>
+#include <utility>
+#include "analysis.h"
+#include "autosave.h"
+#include "bot.h"
 #include "game_controller.h"
+#include "highscores.h"
+#include "journal.h"
+#include "metrics.h"
+#include "pregen.h"
+#include "savefile.h"
+#include "server.h"
+#include "simulator.h"
+#include "solver.h"
+#include "tournament.h"
 #include "ui_controller.h"
 
-bool gameLoop(GameState& state, bool isSaved);
+void playGames(bool persistent);
+bool gameLoop(GameState& state, bool isSaved, bool persistent);
 void saveGame(const GameState& state);
 bool loadGame(GameState& state);
 void deleteSave();
-void loadHighscores(int highScores[40][40][40 * 20], size_t size);
-void saveHighscores(int highScores[40][40][40 * 20], size_t size);
 
-int highScores[40][40][40 * 20] = {0};
+static const char SAVE_FILE[] = "game_state.bin";
+
+int main(int argc, char* argv[]) {
+  SimulationOptions simulation = {0, 16, 30, 99, 0, 0, RNG_XOSHIRO, false};
+  const char* replayPath = nullptr;
+  long long replayAt = -1;
+  const char* serveAddress = nullptr;
+  ServerOptions server = {nullptr, 0, 4096};
+  const char* metricsPath = nullptr;
+  bool analyze = false;
+  bool leaderboard = false;
+  long tournamentGames = 0;
+  std::vector<const char*> strategies;
+  for (int i = 1; i < argc; i++) {
+    const char* value = i + 1 < argc ? argv[i + 1] : "";
+    if (!strcmp(argv[i], "--simulate"))
+      simulation.games = atol(value), i++;
+    else if (!strcmp(argv[i], "--analyze"))
+      simulation.games = atol(value), analyze = true, i++;
+    else if (!strcmp(argv[i], "--tournament"))
+      tournamentGames = atol(value), i++;
+    else if (!strcmp(argv[i], "--strategies") && *value) {
+      for (char* name = strtok(argv[++i], ","); name; name = strtok(nullptr, ","))
+        strategies.push_back(name);
+    } else if (!strcmp(argv[i], "--rows"))
+      simulation.rows = atoi(value), i++;
+    else if (!strcmp(argv[i], "--cols"))
+      simulation.cols = atoi(value), i++;
+    else if (!strcmp(argv[i], "--mines"))
+      simulation.mines = atoi(value), i++;
+    else if (!strcmp(argv[i], "--threads"))
+      simulation.threads = atoi(value), i++;
+    else if (!strcmp(argv[i], "--seed"))
+      simulation.seed = strtoull(value, nullptr, 0), i++;
+    else if (!strcmp(argv[i], "--rng") && !strcmp(value, "mt19937"))
+      simulation.rngKind = RNG_MT19937, i++;
+    else if (!strcmp(argv[i], "--rng") && !strcmp(value, "xoshiro"))
+      simulation.rngKind = RNG_XOSHIRO, i++;
+    else if (!strcmp(argv[i], "--no-guess"))
+      simulation.noGuess = true;
+    else if (!strcmp(argv[i], "--replay") && *value)
+      replayPath = value, i++;
+    else if (!strcmp(argv[i], "--at"))
+      replayAt = atof(value) * 1000, i++;
+    else if (!strcmp(argv[i], "--serve") && *value)
+      serveAddress = value, i++;
+    else if (!strcmp(argv[i], "--max-sessions"))
+      server.maxSessions = atoi(value), i++;
+    else if (!strcmp(argv[i], "--fps"))
+      setFrameRate(atoi(value)), i++;
+    else if (!strcmp(argv[i], "--metrics") && *value)
+      metricsPath = value, i++;
+    else if (!strcmp(argv[i], "--leaderboard"))
+      leaderboard = true;
+    else {
+      fprintf(stderr,
+              "usage: %s [--fps N] [--metrics FILE]\n"
+              "       %s --simulate N [--rows R] [--cols C] [--mines M] "
+              "[--threads T] [--seed S] [--rng xoshiro|mt19937] [--no-guess] "
+              "[--metrics FILE]\n"
+              "       %s --analyze N [--rows R] [--cols C] [--mines M] "
+              "[--threads T] [--seed S] [--rng xoshiro|mt19937] [--no-guess]\n"
+              "       %s --tournament N [--strategies NAME,...] [--rows R] "
+              "[--cols C] [--mines M] [--threads T] [--seed S]\n"
+              "       %s --replay FILE [--at SECONDS]\n"
+              "       %s --leaderboard\n"
+              "       %s --serve SOCKET_PATH|PORT [--max-sessions N] "
+              "[--fps N] [--metrics FILE]\n",
+              argv[0], argv[0], argv[0], argv[0], argv[0], argv[0], argv[0]);
+      return 1;
+    }
+  }
+
+  if (metricsPath) {
+    if (!METRICS_ENABLED) {
+      fprintf(stderr, "built without metrics, rebuild with make METRICS=1\n");
+      return 1;
+    }
+    dumpMetricsTo(metricsPath);
+  }
+
+  if (serveAddress) {
+    // A bare number is a loopback TCP port, anything else a socket path.
+    if (strspn(serveAddress, "0123456789") == strlen(serveAddress))
+      server.port = atoi(serveAddress);
+    else
+      server.socketPath = serveAddress;
+    int status = runServer(server, [] { playGames(false); });
+    stopBoardPool();
+    return status;
+  }
+
+  if (leaderboard) {
+    printLeaderboards();
+    return 0;
+  }
+
+  if (replayPath) {
+    Replay replay;
+    if (!loadReplay(replayPath, replay)) {
+      fprintf(stderr, "%s: not a valid journal\n", replayPath);
+      return 1;
+    }
+    printReplayReport(replay, replayAt);
+    return 0;
+  }
+
+  if (tournamentGames > 0) {
+    if (!Board::validSize(simulation.rows, simulation.cols, simulation.mines)) {
+      fprintf(stderr, "invalid board size\n");
+      return 1;
+    }
+    for (const char* name : strategies)
+      if (!findBotStrategy(name)) {
+        fprintf(stderr, "unknown strategy %s, one of:\n", name);
+        for (const BotInfo& info : botStrategies())
+          fprintf(stderr, "  %-8s %s\n", info.name, info.description);
+        return 1;
+      }
+    TournamentOptions tournament = {tournamentGames, simulation.rows,
+                                    simulation.cols, simulation.mines,
+                                    simulation.threads, simulation.seed,
+                                    strategies};
+    if (tournament.seed == 0)
+      tournament.seed = randomSeed();
+    printTournamentReport(tournament, runTournament(tournament));
+    return 0;
+  }
+
+  if (simulation.games > 0) {
+    if (simulation.rows < 1 || simulation.cols < 1 || simulation.mines < 1 ||
+        simulation.mines >= simulation.rows * simulation.cols) {
+      fprintf(stderr, "invalid board size\n");
+      return 1;
+    }
+    if (simulation.seed == 0)
+      simulation.seed = randomSeed();
+    if (analyze)
+      printAnalysisReport(simulation, runAnalysis(simulation));
+    else
+      printSimulationReport(simulation, runSimulation(simulation));
+    return 0;
+  }
 
-int main() {
   initConsole();
   hideCursor();
+  try {
+    playGames(true);
+  } catch (const InputClosed&) {
+    // Nobody is left to play; the autosave keeps the game for next time.
+  }
+  stopAutosave();
+  stopBoardPool();
+  showCursor();
+  closeConsole();
+  return 0;
+}
 
-  loadHighscores(highScores, sizeof highScores);
-
+// Menus and games on the current terminal until the player quits. Only a
+// persistent player (the console one) has a save file and a journal.
+void playGames(bool persistent) {
   bool playing = true;
 
   do {
     GameState state;
     GameState savedState;
-    bool saved = loadGame(savedState);
+    bool saved = persistent && loadGame(savedState);
 
     int result = mainMenu(saved);
 
@@ -32,47 +199,96 @@ int main() {
       break;
     else if (result == 1) {
       int rows, cols, bombCount;
-      startGameMenu(rows, cols, bombCount);
+      bool noGuess;
+      startGameMenu(rows, cols, bombCount, noGuess);
+      prepareBoards(rows, cols, bombCount, noGuess);
       initBoard(state, rows, cols, bombCount);
+      state.noGuess = noGuess;
     } else if (result == 2) {
-      state = savedState;
+      state = std::move(savedState);
     }
 
-    if (!gameLoop(state, result == 2))
+    if (!gameLoop(state, result == 2, persistent))
       break;
   } while (playing);
-
-  showCursor();
-  closeConsole();
-  return 0;
 }
 
-bool gameLoop(GameState& state, bool isSaved) {
+bool gameLoop(GameState& state, bool isSaved, bool persistent) {
   clearScreenInline(40);
   int cursor_r = 1, cursor_c = 1;
 
-  bool paused = false;
-  std::chrono::steady_clock::time_point startTimepoint, lastTimepoint,
-      currentTimepoint;
+  std::chrono::steady_clock::time_point startTimepoint, pauseTimepoint;
   std::chrono::steady_clock::duration pauseDuration =
       std::chrono::steady_clock::duration::zero();
   if (isSaved)
     startTimepoint = std::chrono::steady_clock::now() -
                      std::chrono::duration_cast<std::chrono::seconds>(
                          std::chrono::duration<float>(state.elapsedTime));
-  while (true) {
-    render(state, cursor_r, cursor_c);
-    currentTimepoint = std::chrono::steady_clock::now();
-    if (paused) {
-      paused = false;
-      if (state.generated)
-        pauseDuration += currentTimepoint - lastTimepoint;
-    }
-    lastTimepoint = currentTimepoint;
+  resetTimer();
+  bool redraw = true;
+  // Hints ignore flags, so they only go stale when more cells are opened.
+  bool showHints = false;
+  int hintedOpened = -1;
+  Hints hints;
+  // After the first save of the board, saves hand over only the cells that
+  // changed since the previous one.
+  std::vector<CellPos> changed;
+  bool boardSaved = false;
+  auto save = [&] {
+    if (boardSaved)
+      autosave(state, SAVE_FILE, changed);
+    else
+      autosave(state, SAVE_FILE);
+    boardSaved = true;
+    changed.clear();
+  };
+  Journal journal;
+  startJournal(journal, state);
+  std::chrono::steady_clock::time_point journalStart =
+      std::chrono::steady_clock::now();
+  auto record = [&](int kind) {
+    JournalEvent event = {kind,
+                          std::chrono::duration_cast<std::chrono::milliseconds>(
+                              std::chrono::steady_clock::now() - journalStart)
+                              .count(),
+                          cursor_r,
+                          cursor_c,
+                          state.seed,
+                          state.rngKind,
+                          state.symmetry};
+    recordEvent(journal, event);
+  };
+  auto updateTime = [&] {
     if (state.generated)
       state.elapsedTime = std::chrono::duration_cast<std::chrono::seconds>(
-                              currentTimepoint - startTimepoint - pauseDuration)
+                              std::chrono::steady_clock::now() -
+                              startTimepoint - pauseDuration)
                               .count();
+  };
+  while (true) {
+    aimBoards(state, cursor_r, cursor_c);
+    updateTime();
+    // Frames are coalesced: a redraw waits until the queued input has been
+    // handled, the frame interval has passed and the terminal has taken the
+    // previous frame, while input keeps being handled.
+    if (redraw && !inputPending() && frameReady()) {
+      redraw = false;
+      if (showHints && state.generated &&
+          hintedOpened != state.openedCount) {
+        runWork([&] { computeHints(state, hints); });
+        hintedOpened = state.openedCount;
+      }
+      render(state, cursor_r, cursor_c, false, false, false,
+             showHints && state.generated ? &hints : nullptr);
+    }
+
+    int events = waitForEvents(EVENT_INPUT | EVENT_RESIZE |
+                               (state.generated ? EVENT_TIMER : 0) |
+                               (redraw ? EVENT_FRAME : 0));
+    if (events & (EVENT_INPUT | EVENT_RESIZE | EVENT_TIMER))
+      redraw = true;
+    if (!(events & EVENT_INPUT))
+      continue;
 
     int keyCode = getInput();
     int mouse_r, mouse_c, mouse_event;
@@ -96,86 +312,91 @@ bool gameLoop(GameState& state, bool isSaved) {
     } else if (keyCode == KEY_UP_ARROW) {
       cursor_r = std::max(1, cursor_r - 1);
     } else if (keyCode == 'f') {
+      record(EVENT_FLAG);
       toggleFlagPosition(state, cursor_r, cursor_c);
+      if (persistent)
+        changed.push_back({cursor_r, cursor_c});
+      if (persistent && state.generated)
+        save();
+    } else if (keyCode == 'h') {
+      showHints = !showHints;
+    } else if (keyCode == 'm') {
+      toggleMetricsOverlay();
     } else if (keyCode == ' ') {
       if (!state.generated) {
-        genBoard(state, cursor_r, cursor_c);
+        runWork([&] { firstClickBoard(state, cursor_r, cursor_c); });
         startTimepoint = std::chrono::steady_clock::now();
+        resetTimer();
+        record(EVENT_GENERATE);
       }
 
-      if (!openPosition(state, cursor_r, cursor_c)) {
+      record(state.cells[cellIndex(state, cursor_r, cursor_c)] & CELL_OPENED
+                 ? EVENT_CHORD
+                 : EVENT_OPEN);
+      bool safe = openPosition(state, cursor_r, cursor_c,
+                               persistent ? &changed : nullptr);
+      // The time of this click, not of the last frame drawn.
+      updateTime();
+      if (!safe) {
+        if (persistent) {
+          writeJournal(journal, JOURNAL_FILE);
+          deleteSave();
+        }
         openAllBomb(state);
-        deleteSave();
         return loseMenu(state, cursor_r, cursor_c);
       }
       if (isWinState(state)) {
-        deleteSave();
-        int modeHighscores =
-            highScores[state.rows - 1][state.cols - 1][state.bombCount - 1];
-        if (modeHighscores == 0 || modeHighscores - 1 > state.elapsedTime) {
-          highScores[state.rows - 1][state.cols - 1][state.bombCount - 1] =
-              state.elapsedTime + 1;
-          saveHighscores(highScores, sizeof highScores);
-          return winMenu(state, state.elapsedTime);
-        } else {
-          return winMenu(state, modeHighscores - 1);
+        if (persistent) {
+          writeJournal(journal, JOURNAL_FILE);
+          deleteSave();
         }
+        int bestTime = getHighscore(state.rows, state.cols, state.bombCount);
+        setHighscore(state.rows, state.cols, state.bombCount,
+                     state.elapsedTime);
+        if (bestTime < 0 || bestTime > state.elapsedTime)
+          bestTime = state.elapsedTime;
+        return winMenu(state, bestTime);
       }
+      if (persistent)
+        save();
     } else if (keyCode == KEY_ESC) {
-      paused = true;
+      record(EVENT_PAUSE);
+      pauseTimepoint = std::chrono::steady_clock::now();
       int result = pauseMenu(state);
+      if (state.generated)
+        pauseDuration += std::chrono::steady_clock::now() - pauseTimepoint;
+      resetTimer();
+      if (result == 1) {
+        record(EVENT_RESUME);
+        continue;
+      }
+      if (persistent)
+        writeJournal(journal, JOURNAL_FILE);
       if (result == 0)
         return false;
-      else if (result == 1)
-        continue;
       else if (result == 2) {
-        saveGame(state);
+        if (persistent)
+          saveGame(state);
         return true;
       }
     }
+    if (cursor_r != journal.r || cursor_c != journal.c)
+      record(EVENT_MOVE);
   }
 }
 
 void saveGame(const GameState& state) {
-  std::ofstream file("game_state.bin", std::ios::binary);
-  if (file.is_open()) {
-    file.write((char*)&state, sizeof state);
-  }
-  file.close();
+  autosave(state, SAVE_FILE);
+  flushAutosave();
 }
 
 bool loadGame(GameState& state) {
-  std::ifstream file("game_state.bin", std::ios::binary);
-  if (!file.is_open())
-    return false;
-
-  if (file.read((char*)&state, sizeof state)) {
-    file.close();
-    return true;
-  } else {
-    file.close();
-    return false;
-  }
+  std::vector<unsigned char> data;
+  return readFile(SAVE_FILE, data) &&
+         decodeSave(data.data(), data.size(), state);
 }
 
 void deleteSave() {
-  std::filesystem::remove("game_state.bin");
-}
-
-void loadHighscores(int highScores[40][40][40 * 20], size_t size) {
-  std::ifstream file("highScores.bin", std::ios::binary);
-  if (!file.is_open())
-    return;
-
-  file.read((char*)highScores, size);
-  file.close();
-}
-
-void saveHighscores(int highScores[40][40][40 * 20], size_t size) {
-  std::ofstream file("highScores.bin", std::ios::binary);
-  if (!file.is_open())
-    return;
-
-  file.write((char*)highScores, size);
-  file.close();
+  cancelAutosave();
+  std::filesystem::remove(SAVE_FILE);
 }
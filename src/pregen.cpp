@@ -0,0 +1,212 @@
+#include "pregen.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "solver.h"
+
+// Sizes pooled at once and boards kept per size (fewer when they are large).
+const int POOL_SIZES = 4;
+const int POOL_BOARDS = 4;
+const long POOL_CELLS = 1 << 24;
+
+// A no-guess board only keeps its guarantee from the cell it was generated
+// for, so those pools hold seeds for the cells the cursor was last aimed at.
+struct PooledSeed {
+  int r, c;
+  uint64_t seed;
+};
+
+struct BoardPool {
+  int rows, cols, mines;
+  bool noGuess;
+  // Set when a no-guess board could not be found, so the size is not retried.
+  bool exhausted;
+  uint64_t used;
+  int aimR, aimC;
+  std::deque<GameState> boards;
+  std::deque<PooledSeed> seeds;
+};
+
+static std::mutex mutex;
+static std::condition_variable wake;
+static std::thread generator;
+static std::vector<BoardPool> pools;
+static uint64_t useCount;
+static bool stopping;
+
+static BoardPool* findPool(int rows, int cols, int mines, bool noGuess) {
+  for (BoardPool& pool : pools)
+    if (pool.rows == rows && pool.cols == cols && pool.mines == mines &&
+        pool.noGuess == noGuess)
+      return &pool;
+  return nullptr;
+}
+
+static size_t poolTarget(const BoardPool& pool) {
+  long cells = (long)pool.rows * pool.cols;
+  return std::max(1L, std::min((long)POOL_BOARDS, POOL_CELLS / cells));
+}
+
+static bool hasSeed(const BoardPool& pool, int r, int c) {
+  for (const PooledSeed& seed : pool.seeds)
+    if (seed.r == r && seed.c == c)
+      return true;
+  return false;
+}
+
+// Removes a seed for (r, c) from the pool, so no two games get its board.
+static bool takeSeed(BoardPool& pool, int r, int c, uint64_t& seed) {
+  for (auto it = pool.seeds.begin(); it != pool.seeds.end(); ++it)
+    if (it->r == r && it->c == c) {
+      seed = it->seed;
+      pool.seeds.erase(it);
+      return true;
+    }
+  return false;
+}
+
+static bool needsBoard(const BoardPool& pool) {
+  if (pool.noGuess)
+    return !pool.exhausted && !hasSeed(pool, pool.aimR, pool.aimC);
+  return pool.boards.size() < poolTarget(pool);
+}
+
+static void generatorLoop() {
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!stopping) {
+    BoardPool* next = nullptr;
+    for (BoardPool& pool : pools)
+      if (needsBoard(pool) && (!next || pool.used > next->used))
+        next = &pool;
+    if (!next) {
+      wake.wait(lock);
+      continue;
+    }
+
+    int rows = next->rows, cols = next->cols, mines = next->mines;
+    bool noGuess = next->noGuess, solvable = true;
+    int r = noGuess ? next->aimR : (rows + 1) / 2;
+    int c = noGuess ? next->aimC : (cols + 1) / 2;
+    lock.unlock();
+    GameState board;
+    initBoard(board, rows, cols, mines);
+    board.noGuess = noGuess;
+    if (noGuess)
+      genBoardNoGuess(board, r, c, randomSeed(), RNG_XOSHIRO,
+                      NO_GUESS_ATTEMPTS, solvable);
+    else
+      genBoard(board, r, c);
+    lock.lock();
+
+    // The size may have been evicted in the meantime.
+    BoardPool* pool = findPool(rows, cols, mines, noGuess);
+    if (!pool)
+      continue;
+    if (!solvable) {
+      pool->exhausted = true;
+    } else if (noGuess) {
+      pool->seeds.push_back({r, c, board.seed});
+      if (pool->seeds.size() > POOL_BOARDS)
+        pool->seeds.pop_front();
+    } else if (pool->boards.size() < poolTarget(*pool)) {
+      pool->boards.push_back(std::move(board));
+    }
+  }
+}
+
+void prepareBoards(int rows, int cols, int mines, bool noGuess) {
+  std::lock_guard<std::mutex> lock(mutex);
+  BoardPool* pool = findPool(rows, cols, mines, noGuess);
+  if (!pool) {
+    if (pools.size() >= POOL_SIZES)
+      pools.erase(std::min_element(pools.begin(), pools.end(),
+                                   [](const BoardPool& a, const BoardPool& b) {
+                                     return a.used < b.used;
+                                   }));
+    pools.push_back({rows, cols, mines, noGuess, false, 0, (rows + 1) / 2,
+                     (cols + 1) / 2, {}, {}});
+    pool = &pools.back();
+  }
+  pool->used = ++useCount;
+  if (!generator.joinable()) {
+    stopping = false;
+    generator = std::thread(generatorLoop);
+  }
+  wake.notify_one();
+}
+
+void aimBoards(const GameState& state, int r, int c) {
+  if (!state.noGuess || state.generated)
+    return;
+  std::lock_guard<std::mutex> lock(mutex);
+  BoardPool* pool = findPool(state.rows, state.cols, state.bombCount, true);
+  if (!pool || (pool->aimR == r && pool->aimC == c))
+    return;
+  pool->aimR = r;
+  pool->aimC = c;
+  wake.notify_one();
+}
+
+void firstClickBoard(GameState& state, int r, int c) {
+  GameState board;
+  uint64_t seed = 0;
+  bool pooled = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    BoardPool* pool =
+        findPool(state.rows, state.cols, state.bombCount, state.noGuess);
+    if (pool && state.noGuess) {
+      pooled = takeSeed(*pool, r, c, seed);
+    } else if (pool && !pool->boards.empty()) {
+      board = std::move(pool->boards.front());
+      pool->boards.pop_front();
+      pooled = true;
+    }
+    if (pool) {
+      pool->used = ++useCount;
+      wake.notify_one();
+    }
+  }
+
+  if (pooled && state.noGuess) {
+    genBoard(state, r, c, seed);
+  } else if (pooled) {
+    // Any symmetry fits a plain board; the one taking the centre closest to
+    // the click needs the smallest shift.
+    int best = 0, bestDistance = -1;
+    for (int symmetry = 0; symmetry < BOARD_SYMMETRIES; symmetry++) {
+      int centreR = (state.rows + 1) / 2, centreC = (state.cols + 1) / 2;
+      if (!validSymmetry(state, symmetry))
+        continue;
+      applySymmetry(state, symmetry, centreR, centreC);
+      int distance = abs(centreR - r) + abs(centreC - c);
+      if (bestDistance < 0 || distance < bestDistance) {
+        best = symmetry;
+        bestDistance = distance;
+      }
+    }
+    moveBoard(board, state, r, c, best);
+  } else if (state.noGuess) {
+    bool solvable;
+    genBoardNoGuess(state, r, c, randomSeed(), RNG_XOSHIRO, NO_GUESS_ATTEMPTS,
+                    solvable);
+  } else {
+    genBoard(state, r, c);
+  }
+}
+
+void stopBoardPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    pools.clear();
+    if (!generator.joinable())
+      return;
+    stopping = true;
+    wake.notify_one();
+  }
+  generator.join();
+}
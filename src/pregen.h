@@ -0,0 +1,25 @@
+#ifndef PREGEN_H
+#define PREGEN_H
+#include "game_controller.h"
+
+// Boards generated ahead of the first click. prepareBoards() asks a
+// background thread, started on first use, to keep a few boards of that size
+// ready; the most recently prepared sizes are kept. Plain boards are
+// generated around the centre cell and firstClickBoard() moves one onto the
+// click with moveBoard(), so the click costs one pass over the board however
+// the mines were placed. Moving would void the no-guess guarantee, so
+// no-guess boards are generated for the cell under the cursor instead and
+// only used if the click lands there. When nothing fits, the board is
+// generated on the spot as before.
+void prepareBoards(int rows, int cols, int mines, bool noGuess);
+
+// The cursor of a game that has no board yet.
+void aimBoards(const GameState& state, int r, int c);
+
+// Generates the board of an initialised state for a first click at (r, c).
+void firstClickBoard(GameState& state, int r, int c);
+
+// Stops the generator thread and drops the pooled boards.
+void stopBoardPool();
+
+#endif
@@ -0,0 +1,26 @@
+#include "rng.h"
+#include <chrono>
+
+void seedRng(Rng& rng, uint64_t seed, RngKind kind) {
+  rng.kind = kind;
+  rng.seed = seed;
+  if (kind == RNG_MT19937) {
+    rng.mt.seed(seed);
+    return;
+  }
+  uint64_t state = seed;
+  for (uint64_t& word : rng.s)
+    word = splitMix64(state);
+}
+
+uint64_t deriveSeed(uint64_t base, uint64_t index) {
+  uint64_t state = base ^ splitMix64(index);
+  return splitMix64(state);
+}
+
+uint64_t randomSeed() {
+  static thread_local uint64_t state =
+      (uint64_t)std::random_device{}() << 32 ^ std::random_device{}() ^
+      std::chrono::steady_clock::now().time_since_epoch().count();
+  return splitMix64(state);
+}
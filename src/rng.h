@@ -0,0 +1,65 @@
+#ifndef RNG_H
+#define RNG_H
+#include <stdint.h>
+#include <random>
+
+enum RngKind { RNG_XOSHIRO = 0, RNG_MT19937 = 1 };
+
+// A small seedable generator: xoshiro256** by default, or std::mt19937_64
+// when results have to match other tools. Not shared between threads.
+struct Rng {
+  RngKind kind;
+  uint64_t seed;
+  uint64_t s[4];
+  std::mt19937_64 mt;
+};
+
+inline uint64_t splitMix64(uint64_t& state) {
+  uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+inline uint64_t nextRandom(Rng& rng) {
+  if (rng.kind == RNG_MT19937)
+    return rng.mt();
+
+  uint64_t* s = rng.s;
+  uint64_t x = s[1] * 5;
+  uint64_t result = (x << 7 | x >> 57) * 9;
+  uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = s[3] << 45 | s[3] >> 19;
+  return result;
+}
+
+// Uniform in [0, bound) without modulo bias (Lemire's multiply-shift).
+inline uint64_t randomBelow(Rng& rng, uint64_t bound) {
+  unsigned __int128 product = (unsigned __int128)nextRandom(rng) * bound;
+  uint64_t low = (uint64_t)product;
+  if (low < bound) {
+    uint64_t threshold = -bound % bound;
+    while (low < threshold) {
+      product = (unsigned __int128)nextRandom(rng) * bound;
+      low = (uint64_t)product;
+    }
+  }
+  return product >> 64;
+}
+
+void seedRng(Rng& rng, uint64_t seed, RngKind kind = RNG_XOSHIRO);
+
+// Derives the seed of item `index` of a run started from `base`, so a batch
+// produces the same boards no matter how it is split across threads.
+uint64_t deriveSeed(uint64_t base, uint64_t index);
+
+// A fresh seed from the operating system, drawn once per thread and then
+// advanced with SplitMix64.
+uint64_t randomSeed();
+
+#endif
@@ -0,0 +1,179 @@
+#include "savefile.h"
+#include <stdio.h>
+#include <string.h>
+#include <filesystem>
+#include <string>
+#include "bitboard.h"
+
+#ifdef _WIN32
+#include <io.h>
+#define fsync(fd) _commit(fd)
+#else
+#include <unistd.h>
+#endif
+
+static const char SAVE_MAGIC[4] = {'M', 'S', 'S', 'V'};
+const size_t SAVE_HEADER_SIZE = 28;
+const int SAVE_FLAG_GENERATED = 1, SAVE_FLAG_NO_GUESS = 2;
+
+struct Crc32Table {
+  uint32_t entries[256];
+  Crc32Table() {
+    for (uint32_t i = 0; i < 256; i++) {
+      uint32_t crc = i;
+      for (int bit = 0; bit < 8; bit++)
+        crc = crc & 1 ? crc >> 1 ^ 0xedb88320u : crc >> 1;
+      entries[i] = crc;
+    }
+  }
+};
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc) {
+  static const Crc32Table table;
+  const unsigned char* bytes = (const unsigned char*)data;
+  crc = ~crc;
+  for (size_t i = 0; i < size; i++)
+    crc = table.entries[(crc ^ bytes[i]) & 0xff] ^ crc >> 8;
+  return ~crc;
+}
+
+static void putLittle(std::vector<unsigned char>& out, uint64_t value,
+                      int bytes) {
+  for (int i = 0; i < bytes; i++)
+    out.push_back(value >> 8 * i & 0xff);
+}
+
+static uint64_t getLittle(const unsigned char* data, int bytes) {
+  uint64_t value = 0;
+  for (int i = 0; i < bytes; i++)
+    value |= (uint64_t)data[i] << 8 * i;
+  return value;
+}
+
+void encodeSave(const GameState& state, std::vector<unsigned char>& out) {
+  long cellCount = (long)state.rows * state.cols;
+  size_t planeSize = (cellCount + 7) / 8;
+  out.clear();
+  out.reserve(SAVE_HEADER_SIZE + 3 * planeSize + 4);
+  out.insert(out.end(), SAVE_MAGIC, SAVE_MAGIC + sizeof SAVE_MAGIC);
+  putLittle(out, SAVE_VERSION, 2);
+  putLittle(out,
+            (state.generated ? SAVE_FLAG_GENERATED : 0) |
+                (state.noGuess ? SAVE_FLAG_NO_GUESS : 0),
+            1);
+  putLittle(out, state.rngKind, 1);
+  putLittle(out, state.rows, 2);
+  putLittle(out, state.cols, 2);
+  putLittle(out, state.bombCount, 4);
+  putLittle(out, state.elapsedTime, 4);
+  putLittle(out, state.seed, 8);
+
+  const unsigned char planeBits[3] = {CELL_MINE, CELL_OPENED, CELL_FLAG};
+  for (unsigned char bit : planeBits) {
+    size_t plane = out.size();
+    out.resize(plane + planeSize, 0);
+    long i = 0;
+    for (int r = 1; r <= state.rows; r++)
+      for (int c = 1; c <= state.cols; c++, i++)
+        if (state.cells[cellIndex(state, r, c)] & bit)
+          out[plane + i / 8] |= 1 << (i % 8);
+  }
+  putLittle(out, crc32(out.data(), out.size()), 4);
+}
+
+bool decodeSave(const unsigned char* data, size_t size, GameState& state) {
+  if (size < SAVE_HEADER_SIZE + 4 ||
+      memcmp(data, SAVE_MAGIC, sizeof SAVE_MAGIC) ||
+      getLittle(data + 4, 2) != SAVE_VERSION ||
+      getLittle(data + size - 4, 4) != crc32(data, size - 4))
+    return false;
+
+  int flags = data[6], rngKind = data[7];
+  int rows = getLittle(data + 8, 2), cols = getLittle(data + 10, 2);
+  long bombCount = getLittle(data + 12, 4);
+  long cellCount = (long)rows * cols;
+  size_t planeSize = (cellCount + 7) / 8;
+  if (rows < 1 || cols < 1 || cellCount > MAX_SAVE_CELLS ||
+      bombCount < 1 || bombCount >= cellCount ||
+      (rngKind != RNG_XOSHIRO && rngKind != RNG_MT19937) ||
+      size != SAVE_HEADER_SIZE + 3 * planeSize + 4)
+    return false;
+
+  initBoard(state, rows, cols, bombCount);
+  state.generated = flags & SAVE_FLAG_GENERATED;
+  state.noGuess = flags & SAVE_FLAG_NO_GUESS;
+  state.rngKind = rngKind;
+  state.elapsedTime = getLittle(data + 16, 4);
+  state.seed = getLittle(data + 20, 8);
+
+  const unsigned char* planes[3];
+  for (int i = 0; i < 3; i++)
+    planes[i] = data + SAVE_HEADER_SIZE + i * planeSize;
+  auto planeBit = [&](int plane, long i) {
+    return planes[plane][i / 8] >> (i % 8) & 1;
+  };
+
+  static thread_local MineBitboard mines;
+  initBitboard(mines, rows, cols);
+  long mineCount = 0, i = 0;
+  for (int r = 1; r <= rows; r++)
+    for (int c = 1; c <= cols; c++, i++)
+      if (planeBit(0, i)) {
+        setMineBit(mines, r, c);
+        mineCount++;
+      }
+  if (mineCount != (state.generated ? bombCount : 0))
+    return false;
+  applyBitboard(mines, state);
+
+  // A lost game is never saved, so an opened mine means the data is wrong.
+  i = 0;
+  for (int r = 1; r <= rows; r++)
+    for (int c = 1; c <= cols; c++, i++) {
+      unsigned char& cell = state.cells[cellIndex(state, r, c)];
+      if (planeBit(1, i)) {
+        if (cell & CELL_MINE)
+          return false;
+        cell |= CELL_OPENED;
+        state.openedCount++;
+      }
+      if (planeBit(2, i)) {
+        cell |= CELL_FLAG;
+        state.flagCount++;
+      }
+    }
+  return true;
+}
+
+bool writeFileAtomic(const char* path, const std::vector<unsigned char>& data) {
+  std::string temp = std::string(path) + ".tmp";
+  FILE* file = fopen(temp.c_str(), "wb");
+  if (!file)
+    return false;
+
+  bool written = fwrite(data.data(), 1, data.size(), file) == data.size() &&
+                 fflush(file) == 0 && fsync(fileno(file)) == 0;
+  if (fclose(file) != 0 || !written) {
+    remove(temp.c_str());
+    return false;
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temp, path, error);
+  return !error;
+}
+
+bool readFile(const char* path, std::vector<unsigned char>& data) {
+  FILE* file = fopen(path, "rb");
+  if (!file)
+    return false;
+
+  data.clear();
+  unsigned char buffer[1 << 14];
+  size_t count;
+  while ((count = fread(buffer, 1, sizeof buffer, file)) > 0)
+    data.insert(data.end(), buffer, buffer + count);
+  bool ok = !ferror(file);
+  fclose(file);
+  return ok;
+}
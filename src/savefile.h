@@ -0,0 +1,32 @@
+#ifndef SAVEFILE_H
+#define SAVEFILE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "game_controller.h"
+
+// Save format, all fields little-endian:
+//   "MSSV", version (u16), flags (u8: generated, noGuess), rngKind (u8),
+//   rows (u16), cols (u16), bombCount (u32), elapsedTime (u32), seed (u64),
+//   three bit planes of rows * cols bits each (mine, opened, flag),
+//   CRC-32 of everything before it (u32).
+// Neighbour counts and the engine counters are rebuilt on load.
+const uint16_t SAVE_VERSION = 1;
+// Larger boards are taken as corruption rather than allocated.
+const long MAX_SAVE_CELLS = 1 << 24;
+
+uint32_t crc32(const void* data, size_t size, uint32_t crc = 0);
+
+void encodeSave(const GameState& state, std::vector<unsigned char>& out);
+
+// Rejects foreign, truncated, corrupted and inconsistent data; `state` is
+// only meaningful when true is returned.
+bool decodeSave(const unsigned char* data, size_t size, GameState& state);
+
+// Writes `path` through a temporary file that is flushed to disk and renamed
+// over it, so a crash leaves either the old file or the new one.
+bool writeFileAtomic(const char* path, const std::vector<unsigned char>& data);
+
+bool readFile(const char* path, std::vector<unsigned char>& data);
+
+#endif
@@ -0,0 +1,738 @@
+#include "server.h"
+#include <stdio.h>
+
+#ifndef __linux__
+
+int runServer(const ServerOptions& options, void (*play)()) {
+  fprintf(stderr, "server mode is only available on Linux\n");
+  return 1;
+}
+
+#else
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "thread_pool.h"
+#include "ui_controller.h"
+
+typedef std::chrono::steady_clock::time_point TimePoint;
+
+// Stacks are reserved, not committed: a session only touches what its deepest
+// call needs. Nothing the game calls recurses deeper than a fixed bound (the
+// hint sampler keeps its path on the heap), and the guard page at the bottom
+// turns an overflow into a crash rather than a write into another session's
+// stack.
+const size_t SESSION_STACK_SIZE = 1 << 20;
+const size_t GUARD_SIZE = 4096;
+// A client that stops reading is dropped once this much output is queued;
+// input beyond the limit is discarded until the game catches up.
+const size_t MAX_PENDING_OUTPUT = 1 << 20;
+const size_t MAX_PENDING_INPUT = 1 << 16;
+const int DEFAULT_WIDTH = 80, DEFAULT_HEIGHT = 24;
+// Opening cells and drawing frames still run on the reactor, so sessions get
+// smaller boards than the console; this also bounds a session's memory.
+const int SESSION_MAX_ROWS = 256, SESSION_MAX_COLS = 256;
+
+// epoll keys that are not sessions.
+const uint64_t LISTENER_ID = 0, SIGNAL_ID = 1, WORK_ID = 2;
+
+const unsigned char TELNET_IAC = 255, TELNET_DO = 253, TELNET_WILL = 251,
+                    TELNET_SB = 250, TELNET_SE = 240;
+const unsigned char OPTION_ECHO = 1, OPTION_SUPPRESS_GO_AHEAD = 3,
+                    OPTION_NAWS = 31;
+
+enum TelnetState {
+  TELNET_DATA,
+  TELNET_CR,
+  TELNET_COMMAND,
+  TELNET_OPTION,
+  TELNET_SUBNEGOTIATION,
+  TELNET_SUBNEGOTIATION_IAC
+};
+
+struct Session {
+  uint64_t id;
+  int fd;
+  Terminal terminal;
+  ucontext_t context;
+  char* stack;
+  std::vector<char> input, output;
+  size_t inputHead = 0, outputHead = 0;
+  // False while the socket is full and EPOLLOUT is armed.
+  bool writable = true;
+  int telnetState = TELNET_DATA;
+  std::vector<unsigned char> subnegotiation;
+  // What the fiber waits for; 0 while it runs or has not started.
+  int waitMask = 0;
+  // EVENT_RESIZE and EVENT_TIMER not yet returned by waitForEvents().
+  int pending = 0;
+  bool tickScheduled = false, frameScheduled = false, queued = false,
+       closed = false, finished = false;
+};
+
+// Work handed over by runWork(), and what a worker caught from it.
+struct Job {
+  uint64_t id;
+  const std::function<void()>* work;
+  std::exception_ptr error;
+};
+
+// A session's next EVENT_TIMER or EVENT_FRAME.
+struct Tick {
+  TimePoint time;
+  uint64_t id;
+  int event;
+  bool operator>(const Tick& other) const { return time > other.time; }
+};
+
+// Thrown inside a fiber whose client went away, to unwind its game.
+struct SessionClosed {};
+
+static ucontext_t reactorContext;
+static int epollFd = -1;
+static void (*playSession)();
+static Session* starting;
+static uint64_t nextId = WORK_ID + 1;
+static std::unordered_map<uint64_t, std::unique_ptr<Session>> sessions;
+static std::vector<Session*> ready;
+static std::priority_queue<Tick, std::vector<Tick>, std::greater<Tick>> ticks;
+
+// Workers take jobs from `jobs` and put them on `doneJobs`, then signal
+// `workFd` so the reactor resumes their sessions.
+static std::mutex jobMutex;
+static std::condition_variable jobWake;
+static std::deque<Job> jobs;
+static std::vector<Job> doneJobs;
+static std::vector<std::thread> workers;
+static bool stoppingWorkers;
+static int workFd = -1;
+
+static bool hasInput(const Session* session) {
+  return session->inputHead < session->input.size();
+}
+
+static bool outputBusy(void* data) {
+  Session* session = (Session*)data;
+  return session->outputHead < session->output.size();
+}
+
+static bool frameDue(Session* session) {
+  return !outputBusy(session) &&
+         std::chrono::steady_clock::now() >= session->terminal.nextFrame;
+}
+
+static void markReady(Session* session) {
+  if (session->queued || !session->waitMask)
+    return;
+  if (session->closed || (session->pending & session->waitMask) ||
+      ((session->waitMask & EVENT_INPUT) && hasInput(session)) ||
+      ((session->waitMask & EVENT_FRAME) && frameDue(session))) {
+    session->queued = true;
+    ready.push_back(session);
+  }
+}
+
+static void watch(Session* session, bool output) {
+  epoll_event event;
+  event.events = EPOLLIN | EPOLLRDHUP | (output ? EPOLLOUT : 0);
+  event.data.u64 = session->id;
+  epoll_ctl(epollFd, EPOLL_CTL_MOD, session->fd, &event);
+}
+
+static void flushSession(Session* session) {
+  while (session->outputHead < session->output.size()) {
+    ssize_t sent = send(session->fd, session->output.data() + session->outputHead,
+                        session->output.size() - session->outputHead,
+                        MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent > 0) {
+      session->outputHead += sent;
+    } else if (sent < 0 && errno == EINTR) {
+      continue;
+    } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (session->writable)
+        watch(session, true);
+      session->writable = false;
+      return;
+    } else {
+      session->closed = true;
+      markReady(session);
+      return;
+    }
+  }
+
+  // A backlog after a burst should not pin its memory for the session's life.
+  if (session->output.capacity() > MAX_PENDING_OUTPUT / 16)
+    std::vector<char>().swap(session->output);
+  session->output.clear();
+  session->outputHead = 0;
+  if (!session->writable) {
+    watch(session, false);
+    session->writable = true;
+    markReady(session);
+  }
+}
+
+// Sends straight from the terminal's buffer and only queues what the socket
+// does not take, so a client that keeps up costs no second copy.
+static void sessionWrite(void* data, const char* bytes, size_t size) {
+  Session* session = (Session*)data;
+  if (session->closed)
+    return;
+  while (session->writable && size > 0) {
+    ssize_t sent = send(session->fd, bytes, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent > 0) {
+      bytes += sent;
+      size -= sent;
+    } else if (sent < 0 && errno == EINTR) {
+      continue;
+    } else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      break;
+    } else {
+      session->closed = true;
+      return;
+    }
+  }
+  if (!size)
+    return;
+
+  session->output.insert(session->output.end(), bytes, bytes + size);
+  flushSession(session);
+  if (session->output.size() - session->outputHead > MAX_PENDING_OUTPUT)
+    session->closed = true;
+}
+
+// Hands over as much buffered input as fits; the UI decodes it.
+static int sessionRead(void* data, char* buffer, int size) {
+  Session* session = (Session*)data;
+  size_t bytes =
+      std::min(session->input.size() - session->inputHead, (size_t)size);
+  memcpy(buffer, session->input.data() + session->inputHead, bytes);
+  session->inputHead += bytes;
+  if (!hasInput(session)) {
+    session->input.clear();
+    session->inputHead = 0;
+  }
+  return bytes;
+}
+
+static int sessionWait(void* data, int mask) {
+  Session* session = (Session*)data;
+  while (true) {
+    if (session->closed)
+      throw SessionClosed();
+    int events = session->pending & mask;
+    if ((mask & EVENT_INPUT) && hasInput(session))
+      events |= EVENT_INPUT;
+    if ((mask & EVENT_FRAME) && frameDue(session))
+      events |= EVENT_FRAME;
+    if (events) {
+      session->pending &= ~events;
+      return events;
+    }
+
+    if ((mask & EVENT_TIMER) && !session->tickScheduled) {
+      ticks.push({session->terminal.nextTick, session->id, EVENT_TIMER});
+      session->tickScheduled = true;
+    }
+    // A backed-up session is woken by flushSession() instead.
+    if ((mask & EVENT_FRAME) && !outputBusy(session) &&
+        !session->frameScheduled) {
+      ticks.push({session->terminal.nextFrame, session->id, EVENT_FRAME});
+      session->frameScheduled = true;
+    }
+    session->waitMask = mask;
+    swapcontext(&session->context, &reactorContext);
+    session->waitMask = 0;
+  }
+}
+
+static void workerLoop() {
+  std::unique_lock<std::mutex> lock(jobMutex);
+  while (true) {
+    jobWake.wait(lock, [] { return !jobs.empty() || stoppingWorkers; });
+    if (jobs.empty())
+      return;
+    Job job = jobs.front();
+    jobs.pop_front();
+    lock.unlock();
+    try {
+      (*job.work)();
+    } catch (...) {
+      job.error = std::current_exception();
+    }
+    uint64_t one = 1;
+    lock.lock();
+    doneJobs.push_back(job);
+    if (write(workFd, &one, sizeof one) < 0) {
+      // The counter is already nonzero; the reactor wakes either way.
+    }
+  }
+}
+
+// Parks the fiber while a worker runs `work`, which may refer to its stack.
+// waitMask stays 0, so only finishWork() resumes it, even if the client goes
+// away in the meantime.
+static void sessionRunWork(void* data, const std::function<void()>& work) {
+  Session* session = (Session*)data;
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    if (workers.empty())
+      for (int i = 0; i < defaultThreadCount(); i++)
+        workers.emplace_back(workerLoop);
+    jobs.push_back({session->id, &work, nullptr});
+  }
+  jobWake.notify_one();
+  swapcontext(&session->context, &reactorContext);
+
+  std::exception_ptr error;
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    for (auto it = doneJobs.begin(); it != doneJobs.end(); ++it)
+      if (it->id == session->id) {
+        error = it->error;
+        doneJobs.erase(it);
+        break;
+      }
+  }
+  if (error)
+    std::rethrow_exception(error);
+}
+
+// Resumes the sessions whose work has finished.
+static void finishWork() {
+  uint64_t count;
+  if (read(workFd, &count, sizeof count) < 0) {
+    // Nothing was signalled.
+  }
+  std::lock_guard<std::mutex> lock(jobMutex);
+  for (const Job& job : doneJobs) {
+    auto it = sessions.find(job.id);
+    if (it == sessions.end() || it->second->queued)
+      continue;
+    it->second->queued = true;
+    ready.push_back(it->second.get());
+  }
+}
+
+static void stopWorkers() {
+  {
+    std::lock_guard<std::mutex> lock(jobMutex);
+    stoppingWorkers = true;
+  }
+  jobWake.notify_all();
+  // Queued work still runs: its fiber needs it done before it can unwind.
+  for (std::thread& worker : workers)
+    worker.join();
+  workers.clear();
+}
+
+static void pushInput(Session* session, char byte) {
+  if (session->input.size() - session->inputHead < MAX_PENDING_INPUT)
+    session->input.push_back(byte);
+}
+
+static void negotiated(Session* session) {
+  const std::vector<unsigned char>& bytes = session->subnegotiation;
+  if (bytes.size() == 5 && bytes[0] == OPTION_NAWS) {
+    int width = bytes[1] << 8 | bytes[2], height = bytes[3] << 8 | bytes[4];
+    if (width > 0 && height > 0) {
+      session->terminal.width = width;
+      session->terminal.height = height;
+      session->pending |= EVENT_RESIZE;
+    }
+  }
+}
+
+// Strips telnet commands from the input, records NAWS window sizes and turns
+// the CR NUL / CR LF that telnet sends for Enter into one '\n'.
+static void parseTelnet(Session* session, const unsigned char* bytes, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    unsigned char byte = bytes[i];
+    switch (session->telnetState) {
+      case TELNET_CR:
+        session->telnetState = TELNET_DATA;
+        if (byte == '\0' || byte == '\n')
+          break;
+        // fall through
+      case TELNET_DATA:
+        if (byte == TELNET_IAC) {
+          session->telnetState = TELNET_COMMAND;
+        } else if (byte == '\r') {
+          pushInput(session, '\n');
+          session->telnetState = TELNET_CR;
+        } else {
+          pushInput(session, byte);
+        }
+        break;
+      case TELNET_COMMAND:
+        if (byte == TELNET_IAC) {
+          pushInput(session, byte);
+          session->telnetState = TELNET_DATA;
+        } else if (byte == TELNET_SB) {
+          session->subnegotiation.clear();
+          session->telnetState = TELNET_SUBNEGOTIATION;
+        } else if (byte >= TELNET_WILL) {
+          session->telnetState = TELNET_OPTION;
+        } else {
+          session->telnetState = TELNET_DATA;
+        }
+        break;
+      case TELNET_OPTION:
+        session->telnetState = TELNET_DATA;
+        break;
+      case TELNET_SUBNEGOTIATION:
+        if (byte == TELNET_IAC)
+          session->telnetState = TELNET_SUBNEGOTIATION_IAC;
+        else if (session->subnegotiation.size() < 64)
+          session->subnegotiation.push_back(byte);
+        break;
+      case TELNET_SUBNEGOTIATION_IAC:
+        if (byte == TELNET_SE) {
+          negotiated(session);
+          session->telnetState = TELNET_DATA;
+        } else {
+          if (byte == TELNET_IAC && session->subnegotiation.size() < 64)
+            session->subnegotiation.push_back(byte);
+          session->telnetState = TELNET_SUBNEGOTIATION;
+        }
+        break;
+    }
+  }
+}
+
+static void readSession(Session* session) {
+  unsigned char buffer[4096];
+  while (true) {
+    ssize_t count = recv(session->fd, buffer, sizeof buffer, MSG_DONTWAIT);
+    if (count > 0) {
+      parseTelnet(session, buffer, count);
+    } else if (count < 0 && errno == EINTR) {
+      continue;
+    } else {
+      if (count == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        session->closed = true;
+      break;
+    }
+  }
+  markReady(session);
+}
+
+static void sessionMain() {
+  Session* session = starting;
+  try {
+    hideCursor();
+    setMouseReporting(true);
+    clearScreen(40);
+    playSession();
+    setMouseReporting(false);
+    showCursor();
+    clearScreen(0);
+  } catch (const SessionClosed&) {
+  }
+  session->finished = true;
+}
+
+static void destroySession(Session* session) {
+  epoll_ctl(epollFd, EPOLL_CTL_DEL, session->fd, nullptr);
+  close(session->fd);
+  munmap(session->stack, SESSION_STACK_SIZE);
+  sessions.erase(session->id);
+}
+
+static void resume(Session* session) {
+  Terminal* previous = setTerminal(&session->terminal);
+  swapcontext(&reactorContext, &session->context);
+  setTerminal(previous);
+  if (session->finished) {
+    if (!session->closed)
+      flushSession(session);
+    destroySession(session);
+  }
+}
+
+static void startSession(int fd) {
+  void* stack = mmap(nullptr, SESSION_STACK_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                     -1, 0);
+  if (stack == MAP_FAILED) {
+    close(fd);
+    return;
+  }
+  if (mprotect(stack, GUARD_SIZE, PROT_NONE) < 0) {
+    close(fd);
+    munmap(stack, SESSION_STACK_SIZE);
+    return;
+  }
+
+  std::unique_ptr<Session> owner(new Session());
+  Session* session = owner.get();
+  session->id = nextId++;
+  session->fd = fd;
+  session->stack = (char*)stack;
+  Terminal& terminal = session->terminal;
+  terminal.session = session;
+  terminal.waitEvents = sessionWait;
+  terminal.readInput = sessionRead;
+  terminal.writeOutput = sessionWrite;
+  terminal.outputBusy = outputBusy;
+  terminal.runWork = sessionRunWork;
+  terminal.maxRows = SESSION_MAX_ROWS;
+  terminal.maxCols = SESSION_MAX_COLS;
+  terminal.width = DEFAULT_WIDTH;
+  terminal.height = DEFAULT_HEIGHT;
+  terminal.nextTick = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+
+  getcontext(&session->context);
+  session->context.uc_stack.ss_sp = stack;
+  session->context.uc_stack.ss_size = SESSION_STACK_SIZE;
+  session->context.uc_link = &reactorContext;
+  makecontext(&session->context, sessionMain, 0);
+
+  epoll_event event;
+  event.events = EPOLLIN | EPOLLRDHUP;
+  event.data.u64 = session->id;
+  if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+    close(fd);
+    munmap(stack, SESSION_STACK_SIZE);
+    return;
+  }
+  sessions[session->id] = std::move(owner);
+
+  const unsigned char negotiation[] = {
+      TELNET_IAC, TELNET_WILL, OPTION_ECHO,
+      TELNET_IAC, TELNET_WILL, OPTION_SUPPRESS_GO_AHEAD,
+      TELNET_IAC, TELNET_DO,   OPTION_NAWS};
+  sessionWrite(session, (const char*)negotiation, sizeof negotiation);
+  starting = session;
+  resume(session);
+}
+
+static void acceptSessions(int listener, int maxSessions) {
+  while (true) {
+    int fd = accept4(listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED)
+        continue;
+      return;
+    }
+    if ((int)sessions.size() >= maxSessions) {
+      const char message[] = "Server full, try again later.\r\n";
+      if (send(fd, message, sizeof message - 1, MSG_NOSIGNAL) < 0) {
+        // Dropped either way.
+      }
+      close(fd);
+      continue;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+    startSession(fd);
+  }
+}
+
+static void fireTicks(TimePoint now) {
+  while (!ticks.empty() && ticks.top().time <= now) {
+    uint64_t id = ticks.top().id;
+    int event = ticks.top().event;
+    ticks.pop();
+    auto it = sessions.find(id);
+    if (it == sessions.end())
+      continue;
+
+    Session* session = it->second.get();
+    if (event == EVENT_FRAME) {
+      session->frameScheduled = false;
+      if (now < session->terminal.nextFrame &&
+          (session->waitMask & EVENT_FRAME)) {
+        ticks.push({session->terminal.nextFrame, id, EVENT_FRAME});
+        session->frameScheduled = true;
+      }
+      markReady(session);
+      continue;
+    }
+    session->tickScheduled = false;
+    if (now >= session->terminal.nextTick) {
+      session->terminal.nextTick += std::chrono::seconds(1);
+      session->pending |= EVENT_TIMER;
+      markReady(session);
+    } else if (session->waitMask & EVENT_TIMER) {
+      // resetTimer() moved the tick since it was scheduled.
+      ticks.push({session->terminal.nextTick, id, EVENT_TIMER});
+      session->tickScheduled = true;
+    }
+  }
+}
+
+static void runReady() {
+  std::vector<Session*> batch;
+  batch.swap(ready);
+  for (Session* session : batch) {
+    session->queued = false;
+    resume(session);
+  }
+}
+
+static int openListener(const ServerOptions& options) {
+  int fd;
+  if (options.socketPath) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof address);
+    address.sun_family = AF_UNIX;
+    if (strlen(options.socketPath) >= sizeof address.sun_path) {
+      fprintf(stderr, "socket path too long\n");
+      return -1;
+    }
+    strcpy(address.sun_path, options.socketPath);
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    unlink(options.socketPath);
+    if (fd < 0 || bind(fd, (sockaddr*)&address, sizeof address) < 0) {
+      perror(options.socketPath);
+      return -1;
+    }
+  } else {
+    sockaddr_in address;
+    memset(&address, 0, sizeof address);
+    address.sin_family = AF_INET;
+    address.sin_port = htons(options.port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    int one = 1;
+    if (fd >= 0)
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    if (fd < 0 || bind(fd, (sockaddr*)&address, sizeof address) < 0) {
+      perror("bind");
+      return -1;
+    }
+  }
+  if (listen(fd, SOMAXCONN) < 0) {
+    perror("listen");
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int runServer(const ServerOptions& options, void (*play)()) {
+  playSession = play;
+
+  // Every session is a socket; allow as many as the hard limit does.
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+  signal(SIGPIPE, SIG_IGN);
+
+  int listener = openListener(options);
+  if (listener < 0)
+    return 1;
+
+  sigset_t stopSignals;
+  sigemptyset(&stopSignals);
+  sigaddset(&stopSignals, SIGINT);
+  sigaddset(&stopSignals, SIGTERM);
+  sigprocmask(SIG_BLOCK, &stopSignals, nullptr);
+  int signalFd = signalfd(-1, &stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+
+  epollFd = epoll_create1(EPOLL_CLOEXEC);
+  epoll_event event;
+  event.events = EPOLLIN;
+  event.data.u64 = LISTENER_ID;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, listener, &event);
+  event.data.u64 = SIGNAL_ID;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &event);
+  workFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  event.data.u64 = WORK_ID;
+  epoll_ctl(epollFd, EPOLL_CTL_ADD, workFd, &event);
+
+  if (options.socketPath)
+    fprintf(stderr, "listening on %s\n", options.socketPath);
+  else
+    fprintf(stderr, "listening on 127.0.0.1:%d\n", options.port);
+
+  bool running = true;
+  epoll_event events[256];
+  while (running) {
+    int timeout = -1;
+    if (!ticks.empty()) {
+      auto wait = ticks.top().time - std::chrono::steady_clock::now();
+      timeout = std::max<long>(
+          0, std::chrono::ceil<std::chrono::milliseconds>(wait).count());
+    }
+
+    int count = epoll_wait(epollFd, events, 256, timeout);
+    if (count < 0 && errno != EINTR)
+      break;
+    for (int i = 0; i < count; i++) {
+      uint64_t id = events[i].data.u64;
+      if (id == LISTENER_ID) {
+        acceptSessions(listener, options.maxSessions);
+        continue;
+      }
+      if (id == SIGNAL_ID) {
+        running = false;
+        continue;
+      }
+      if (id == WORK_ID) {
+        finishWork();
+        continue;
+      }
+      auto it = sessions.find(id);
+      if (it == sessions.end())
+        continue;
+      Session* session = it->second.get();
+      if (events[i].events & EPOLLOUT)
+        flushSession(session);
+      if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+        readSession(session);
+    }
+
+    fireTicks(std::chrono::steady_clock::now());
+    runReady();
+  }
+
+  // Unwind every game so its stack and socket are released, once the work
+  // that parked some of them has finished.
+  stopWorkers();
+  std::vector<Session*> remaining;
+  for (auto& entry : sessions)
+    remaining.push_back(entry.second.get());
+  for (Session* session : remaining) {
+    session->closed = true;
+    resume(session);
+  }
+
+  close(epollFd);
+  close(signalFd);
+  close(workFd);
+  close(listener);
+  if (options.socketPath)
+    unlink(options.socketPath);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+struct ServerOptions {
+  // Unix domain socket to listen on, or null to listen on TCP port `port`
+  // of the loopback interface.
+  const char* socketPath;
+  int port;
+  int maxSessions;
+};
+
+// Hosts independent games for many terminal clients in one process (Linux
+// only). A single epoll reactor thread owns every socket. Each session runs
+// `play` as a fiber on its own stack with its own Terminal, and is switched
+// out whenever the UI waits for events, so the blocking menus and game loop
+// serve every session unchanged. Clients speak telnet: the server turns off
+// local echo and line mode and takes the window size from NAWS. Runs until
+// SIGINT or SIGTERM; returns the process exit status.
+int runServer(const ServerOptions& options, void (*play)());
+
+#endif
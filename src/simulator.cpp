@@ -0,0 +1,196 @@
+#include "simulator.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "metrics.h"
+#include "solver.h"
+#include "thread_pool.h"
+
+// Opening a cell can make it or any of its neighbours decidable.
+static void queueOpened(const GameState& state,
+                        const int offset[8],
+                        std::vector<CellPos>& opened,
+                        std::vector<int>& queue) {
+  for (const CellPos& cell : opened) {
+    int index = cellIndex(state, cell.r, cell.c);
+    queue.push_back(index);
+    for (int i = 0; i < 8; i++)
+      queue.push_back(index + offset[i]);
+  }
+  opened.clear();
+}
+
+static bool guessCell(GameState& state, Rng& rng, int& r, int& c) {
+  const unsigned char hidden = CELL_OPENED | CELL_FLAG;
+  for (int attempt = 0; attempt < 32; attempt++) {
+    r = randomBelow(rng, state.rows) + 1;
+    c = randomBelow(rng, state.cols) + 1;
+    if (!(state.cells[cellIndex(state, r, c)] & hidden))
+      return true;
+  }
+
+  long total = (long)state.rows * state.cols;
+  long start = randomBelow(rng, total);
+  for (long i = 0; i < total; i++) {
+    long position = (start + i) % total;
+    r = position / state.cols + 1;
+    c = position % state.cols + 1;
+    if (!(state.cells[cellIndex(state, r, c)] & hidden))
+      return true;
+  }
+  return false;
+}
+
+bool autoPlay(GameState& state, Rng& rng) {
+  static thread_local std::vector<CellPos> opened;
+  static thread_local std::vector<int> queue;
+  opened.clear();
+  queue.clear();
+
+  int offset[8] = {-state.stride - 1, -state.stride, -state.stride + 1, -1,
+                   1, state.stride - 1, state.stride, state.stride + 1};
+
+  int r = (state.rows + 1) / 2, c = (state.cols + 1) / 2;
+  if (!state.generated)
+    genBoard(state, r, c, nextRandom(rng), rng.kind);
+  if (!openPosition(state, r, c, &opened))
+    return false;
+  queueOpened(state, offset, opened, queue);
+
+  while (!isWinState(state)) {
+    while (!queue.empty()) {
+      int index = queue.back();
+      queue.pop_back();
+      unsigned char cell = state.cells[index];
+      int number = cell & CELL_COUNT;
+      if (!(cell & CELL_OPENED) || number == 0)
+        continue;
+
+      int unknown = 0, flags = 0;
+      for (int i = 0; i < 8; i++) {
+        unsigned char neighbour = state.cells[index + offset[i]];
+        if (neighbour & CELL_FLAG)
+          flags++;
+        else if (!(neighbour & CELL_OPENED))
+          unknown++;
+      }
+      if (unknown == 0)
+        continue;
+
+      r = index / state.stride;
+      c = index % state.stride;
+      if (flags == number) {
+        if (!openPosition(state, r, c, &opened))
+          return false;
+        queueOpened(state, offset, opened, queue);
+      } else if (flags + unknown == number) {
+        for (int i = 0; i < 8; i++) {
+          int flagged = index + offset[i];
+          if (state.cells[flagged] & (CELL_FLAG | CELL_OPENED))
+            continue;
+          toggleFlagPosition(state, flagged / state.stride,
+                             flagged % state.stride);
+          for (int k = 0; k < 8; k++)
+            queue.push_back(flagged + offset[k]);
+        }
+      }
+    }
+
+    if (isWinState(state))
+      break;
+    if (!guessCell(state, rng, r, c) || !openPosition(state, r, c, &opened))
+      return false;
+    queueOpened(state, offset, opened, queue);
+  }
+  return true;
+}
+
+SimulationReport runSimulation(const SimulationOptions& options) {
+  int threads = options.threads > 0 ? options.threads : defaultThreadCount();
+  std::vector<std::vector<int64_t>> latencies(threads), generations(threads);
+  std::vector<long> wins(threads, 0), attempts(threads, 0),
+      unsolvable(threads, 0);
+  auto start = std::chrono::steady_clock::now();
+  parallelFor(options.games, threads, 256, [&](int worker, long begin,
+                                               long end) {
+    static thread_local GameState state;
+    static thread_local Rng rng;
+
+    std::vector<int64_t>& latency = latencies[worker];
+    for (long game = begin; game < end; game++) {
+      auto gameStart = std::chrono::steady_clock::now();
+      seedRng(rng, deriveSeed(options.seed, game), options.rngKind);
+      initBoard(state, options.rows, options.cols, options.mines);
+      if (options.noGuess) {
+        bool solvable;
+        attempts[worker] += genBoardNoGuess(
+            state, (state.rows + 1) / 2, (state.cols + 1) / 2,
+            nextRandom(rng), rng.kind, NO_GUESS_ATTEMPTS, solvable);
+        unsolvable[worker] += !solvable;
+        generations[worker].push_back(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - gameStart)
+                .count());
+      }
+      wins[worker] += autoPlay(state, rng);
+      latency.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - gameStart)
+                            .count());
+    }
+  });
+
+  SimulationReport report;
+  report.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  report.games = options.games;
+  report.wins = 0;
+  report.attempts = 0;
+  report.unsolvable = 0;
+  std::vector<int64_t> all, generation;
+  all.reserve(options.games);
+  for (int i = 0; i < threads; i++) {
+    report.wins += wins[i];
+    report.attempts += attempts[i];
+    report.unsolvable += unsolvable[i];
+    all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+    generation.insert(generation.end(), generations[i].begin(),
+                      generations[i].end());
+  }
+  std::sort(generation.begin(), generation.end());
+  report.generationP50 = percentile(generation, 0.5);
+  report.generationP99 = percentile(generation, 0.99);
+  report.generationMax = generation.empty() ? 0 : generation.back() / 1000.0;
+  std::sort(all.begin(), all.end());
+  report.p50 = percentile(all, 0.5);
+  report.p90 = percentile(all, 0.9);
+  report.p99 = percentile(all, 0.99);
+  report.p999 = percentile(all, 0.999);
+  report.max = all.empty() ? 0 : all.back() / 1000.0;
+  return report;
+}
+
+void printSimulationReport(const SimulationOptions& options,
+                           const SimulationReport& report) {
+  printf("board:        %dx%d, %d mines\n", options.rows, options.cols,
+         options.mines);
+  printf("seed:         %llu (%s)\n", (unsigned long long)options.seed,
+         options.rngKind == RNG_MT19937 ? "mt19937_64" : "xoshiro256**");
+  printf("threads:      %d\n",
+         options.threads > 0 ? options.threads : defaultThreadCount());
+  printf("games:        %ld in %.3fs\n", report.games, report.seconds);
+  printf("games/s:      %.0f\n",
+         report.seconds > 0 ? report.games / report.seconds : 0.0);
+  printf("win rate:     %.2f%% (%ld wins)\n",
+         report.games ? 100.0 * report.wins / report.games : 0.0, report.wins);
+  printf("latency (us): p50 %.1f  p90 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+         report.p50, report.p90, report.p99, report.p999, report.max);
+  if (options.noGuess) {
+    printf("no-guess:     %.2f attempts/board, %ld unsolvable\n",
+           report.games ? (double)report.attempts / report.games : 0.0,
+           report.unsolvable);
+    printf("generation (us): p50 %.1f  p99 %.1f  max %.1f\n",
+           report.generationP50, report.generationP99, report.generationMax);
+  }
+}
@@ -0,0 +1,39 @@
+#ifndef SIMULATOR_H
+#define SIMULATOR_H
+#include <stdint.h>
+#include "game_controller.h"
+#include "rng.h"
+
+struct SimulationOptions {
+  long games;
+  int rows, cols, mines, threads;
+  // Game i is played from deriveSeed(seed, i), whichever thread runs it.
+  uint64_t seed;
+  RngKind rngKind;
+  // Generate every board with genBoardNoGuess() from the centre cell.
+  bool noGuess;
+};
+
+struct SimulationReport {
+  long games, wins;
+  double seconds;
+  // Per-game latency percentiles, in microseconds.
+  double p50, p90, p99, p999, max;
+  // No-guess generation only: total attempts, boards that stayed unsolvable
+  // after NO_GUESS_ATTEMPTS, and generation time percentiles in microseconds.
+  long attempts, unsolvable;
+  double generationP50, generationP99, generationMax;
+};
+
+// Plays one game from an initialised, not yet generated state with the
+// built-in strategy: open the centre, then apply the single-cell rules to
+// every number that changed and guess a random cell when nothing is certain.
+// The board seed is the first draw from rng, guesses use the rest; a state
+// that is already generated is played as is.
+bool autoPlay(GameState& state, Rng& rng);
+
+SimulationReport runSimulation(const SimulationOptions& options);
+void printSimulationReport(const SimulationOptions& options,
+                           const SimulationReport& report);
+
+#endif
@@ -0,0 +1,1045 @@
+#include "solver.h"
+#include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+const int MAX_COMPONENT_CELLS = 48;
+const long MAX_ENUMERATION_NODES = 1 << 16;
+const int MAX_OPEN_NUMBERS = 32;
+const size_t MAX_TRANSITIONS = 1 << 18;
+const size_t MAX_TALLY_ENTRIES = 1 << 17;
+const size_t MAX_CACHED_ENTRIES = 1 << 22;
+// Beyond this many entries in the mine count tables of computeHints(),
+// components are weighed by the mine density instead.
+const size_t MAX_MINE_COUNT_ENTRIES = 1 << 22;
+const int HINT_SAMPLES = 256;
+const long MAX_SAMPLE_NODES = 1 << 17;
+
+// Hidden neighbours are also kept as bits of a 7x7 window centred on the
+// number, so two numbers up to two cells apart compare with a shift.
+const int WINDOW_BIT[8] = {16, 17, 18, 23, 25, 30, 31, 32};
+
+struct Constraint {
+  int cell, r, c;
+  int mines;
+  int count;
+  int unknown[8];
+  uint64_t window;
+};
+
+struct FrontierCell {
+  int cell;
+  int count;
+  int constraints[8];
+};
+
+struct SolverScratch {
+  int offset[8];
+  std::vector<int> queue;
+  std::vector<unsigned char> queued;
+  std::vector<CellPos> opened;
+  std::vector<int> safe, mines;
+  // Opened numbers that had hidden neighbours when last looked at.
+  std::vector<int> active;
+  std::vector<unsigned char> inActive;
+  std::vector<Constraint> constraints;
+  std::vector<int> constraintOf;
+  // Frontier cells grouped by component, each in breadth-first order so the
+  // search assigns cells of the same number close together.
+  std::vector<FrontierCell> frontier;
+  std::vector<unsigned char> inFrontier, visited;
+  std::vector<int> pending;
+  std::vector<int> remaining, unassigned;
+  std::vector<int> assignment;
+  // Per depth of a sampling descent: the value tried first, and how many
+  // values have been tried.
+  std::vector<unsigned char> firstValue, triedValues;
+  std::vector<long> mineSolutions;
+  long nodes;
+};
+
+static thread_local SolverScratch scratch;
+
+static bool isHidden(unsigned char cell) {
+  return !(cell & (CELL_OPENED | CELL_FLAG));
+}
+
+static void queueAround(SolverScratch& s, int index) {
+  for (int i = -1; i < 8; i++) {
+    int cell = i < 0 ? index : index + s.offset[i];
+    if (!s.queued[cell]) {
+      s.queued[cell] = 1;
+      s.queue.push_back(cell);
+    }
+  }
+}
+
+// Flags s.mines and opens s.safe, queueing everything around them for the
+// single-cell rules.
+static bool applyDeductions(SolverScratch& s, GameState& state) {
+  for (int index : s.mines) {
+    if (!isHidden(state.cells[index]))
+      continue;
+    toggleFlagPosition(state, index / state.stride, index % state.stride);
+    queueAround(s, index);
+  }
+  for (int index : s.safe) {
+    if (!isHidden(state.cells[index]))
+      continue;
+    if (!openPosition(state, index / state.stride, index % state.stride,
+                      &s.opened))
+      return false;
+    for (const CellPos& cell : s.opened)
+      queueAround(s, cellIndex(state, cell.r, cell.c));
+    s.opened.clear();
+  }
+  s.mines.clear();
+  s.safe.clear();
+  return true;
+}
+
+static bool singleCellRules(SolverScratch& s, GameState& state) {
+  while (!s.queue.empty()) {
+    int index = s.queue.back();
+    s.queue.pop_back();
+    s.queued[index] = 0;
+    unsigned char cell = state.cells[index];
+    int number = cell & CELL_COUNT;
+    if (!(cell & CELL_OPENED) || (cell & CELL_MINE) || number == 0)
+      continue;
+
+    int hidden = 0, flags = 0;
+    for (int i = 0; i < 8; i++) {
+      unsigned char neighbour = state.cells[index + s.offset[i]];
+      if (neighbour & CELL_FLAG)
+        flags++;
+      else if (!(neighbour & CELL_OPENED))
+        hidden++;
+    }
+    if (hidden == 0)
+      continue;
+    if (flags != number && flags + hidden != number) {
+      if (!s.inActive[index]) {
+        s.inActive[index] = 1;
+        s.active.push_back(index);
+      }
+      continue;
+    }
+
+    std::vector<int>& target = flags == number ? s.safe : s.mines;
+    for (int i = 0; i < 8; i++)
+      if (isHidden(state.cells[index + s.offset[i]]))
+        target.push_back(index + s.offset[i]);
+    if (!applyDeductions(s, state))
+      return false;
+  }
+  return true;
+}
+
+// Turns the active numbers into constraints, dropping the ones whose hidden
+// neighbours have all been resolved since.
+static void buildConstraints(SolverScratch& s, const GameState& state) {
+  for (const Constraint& constraint : s.constraints)
+    s.constraintOf[constraint.cell] = -1;
+  s.constraints.clear();
+
+  size_t kept = 0;
+  for (int index : s.active) {
+    Constraint constraint;
+    constraint.cell = index;
+    constraint.r = index / state.stride;
+    constraint.c = index % state.stride;
+    constraint.mines = state.cells[index] & CELL_COUNT;
+    constraint.count = 0;
+    constraint.window = 0;
+    for (int i = 0; i < 8; i++) {
+      unsigned char neighbour = state.cells[index + s.offset[i]];
+      if (neighbour & CELL_FLAG) {
+        constraint.mines--;
+      } else if (!(neighbour & CELL_OPENED)) {
+        constraint.unknown[constraint.count++] = index + s.offset[i];
+        constraint.window |= 1ULL << WINDOW_BIT[i];
+      }
+    }
+    if (constraint.count == 0) {
+      s.inActive[index] = 0;
+      continue;
+    }
+    s.active[kept++] = index;
+    s.constraintOf[index] = s.constraints.size();
+    s.constraints.push_back(constraint);
+  }
+  s.active.resize(kept);
+}
+
+static void pushWindow(std::vector<int>& cells,
+                       const Constraint& origin,
+                       uint64_t window,
+                       int stride) {
+  while (window) {
+    int bit = __builtin_ctzll(window);
+    window &= window - 1;
+    cells.push_back(origin.cell + (bit / 7 - 3) * stride + bit % 7 - 3);
+  }
+}
+
+// For two numbers A and B sharing hidden cells: if A needs as many more
+// mines than B as it has cells B does not see, those cells are all mines and
+// B's own cells are all safe.
+static void pairRule(SolverScratch& s,
+                     const Constraint& a,
+                     const Constraint& b,
+                     int stride) {
+  int shift = (b.r - a.r) * 7 + b.c - a.c;
+  uint64_t shared = shift >= 0 ? b.window << shift : b.window >> -shift;
+  uint64_t onlyA = a.window & ~shared, onlyB = shared & ~a.window;
+  if (!(onlyA | onlyB))
+    return;
+
+  if (a.mines - b.mines == __builtin_popcountll(onlyA)) {
+    pushWindow(s.mines, a, onlyA, stride);
+    pushWindow(s.safe, a, onlyB, stride);
+  } else if (b.mines - a.mines == __builtin_popcountll(onlyB)) {
+    pushWindow(s.mines, a, onlyB, stride);
+    pushWindow(s.safe, a, onlyA, stride);
+  }
+}
+
+static bool subsetRules(SolverScratch& s, const GameState& state) {
+  for (int id = 0; id < (int)s.constraints.size(); id++) {
+    const Constraint& a = s.constraints[id];
+    int seen[24], seenCount = 0;
+    for (int i = 0; i < a.count; i++)
+      for (int k = 0; k < 8; k++) {
+        int other = s.constraintOf[a.unknown[i] + s.offset[k]];
+        if (other <= id ||
+            std::find(seen, seen + seenCount, other) != seen + seenCount)
+          continue;
+        if (seenCount < 24)
+          seen[seenCount++] = other;
+        pairRule(s, a, s.constraints[other], state.stride);
+      }
+  }
+  return !s.safe.empty() || !s.mines.empty();
+}
+
+// Tries to give a frontier cell the value `mine`, keeping every number it
+// touches satisfiable by the cells still unassigned.
+static bool assignCell(SolverScratch& s, const FrontierCell& cell, int mine) {
+  for (int i = 0; i < cell.count; i++) {
+    int k = cell.constraints[i];
+    int rem = s.remaining[k] - mine;
+    if (rem < 0 || rem > s.unassigned[k] - 1)
+      return false;
+  }
+  for (int i = 0; i < cell.count; i++) {
+    s.remaining[cell.constraints[i]] -= mine;
+    s.unassigned[cell.constraints[i]]--;
+  }
+  return true;
+}
+
+static void unassignCell(SolverScratch& s, const FrontierCell& cell, int mine) {
+  for (int i = 0; i < cell.count; i++) {
+    s.remaining[cell.constraints[i]] += mine;
+    s.unassigned[cell.constraints[i]]++;
+  }
+}
+
+static bool enumerate(SolverScratch& s,
+                      int first,
+                      int last,
+                      int depth,
+                      int placed,
+                      int maxMines,
+                      int exactMines) {
+  if (++s.nodes > MAX_ENUMERATION_NODES)
+    return false;
+  if (first + depth == last) {
+    if (exactMines >= 0 && placed != exactMines)
+      return true;
+    s.mineSolutions.back()++;
+    for (int i = 0; i < depth; i++)
+      s.mineSolutions[i] += s.assignment[i];
+    return true;
+  }
+
+  const FrontierCell& cell = s.frontier[first + depth];
+  for (int mine = 0; mine <= 1 && placed + mine <= maxMines; mine++) {
+    if (!assignCell(s, cell, mine))
+      continue;
+    s.assignment[depth] = mine;
+    bool finished = enumerate(s, first, last, depth + 1, placed + mine,
+                              maxMines, exactMines);
+    unassignCell(s, cell, mine);
+    if (!finished)
+      return false;
+  }
+  return true;
+}
+
+// Appends the component holding constraint `id` to s.frontier.
+static void collectComponent(SolverScratch& s, int id) {
+  s.pending.clear();
+  s.pending.push_back(id);
+  s.visited[id] = 1;
+  for (size_t p = 0; p < s.pending.size(); p++) {
+    const Constraint& constraint = s.constraints[s.pending[p]];
+    for (int i = 0; i < constraint.count; i++) {
+      int index = constraint.unknown[i];
+      if (s.inFrontier[index])
+        continue;
+      s.inFrontier[index] = 1;
+
+      FrontierCell cell;
+      cell.cell = index;
+      cell.count = 0;
+      for (int k = 0; k < 8; k++) {
+        int other = s.constraintOf[index + s.offset[k]];
+        if (other < 0)
+          continue;
+        cell.constraints[cell.count++] = other;
+        if (!s.visited[other]) {
+          s.visited[other] = 1;
+          s.pending.push_back(other);
+        }
+      }
+      s.frontier.push_back(cell);
+    }
+  }
+}
+
+static bool componentRules(SolverScratch& s,
+                           const GameState& state,
+                           int hiddenTotal) {
+  int remainingMines = state.bombCount - state.flagCount;
+  for (const FrontierCell& cell : s.frontier)
+    s.inFrontier[cell.cell] = 0;
+  s.frontier.clear();
+  s.visited.assign(s.constraints.size(), 0);
+  s.remaining.resize(s.constraints.size());
+  s.unassigned.resize(s.constraints.size());
+  for (int id = 0; id < (int)s.constraints.size(); id++) {
+    s.remaining[id] = s.constraints[id].mines;
+    s.unassigned[id] = s.constraints[id].count;
+  }
+
+  for (int id = 0; id < (int)s.constraints.size(); id++) {
+    if (s.visited[id])
+      continue;
+    int first = s.frontier.size();
+    collectComponent(s, id);
+    int last = s.frontier.size();
+    if (last - first > MAX_COMPONENT_CELLS)
+      continue;
+
+    // Only a component covering every hidden cell must use all the mines.
+    int exactMines =
+        first == 0 && last == hiddenTotal ? remainingMines : -1;
+    s.assignment.assign(last - first, 0);
+    s.mineSolutions.assign(last - first + 1, 0);
+    s.nodes = 0;
+    if (!enumerate(s, first, last, 0, 0, remainingMines, exactMines) ||
+        s.mineSolutions.back() == 0)
+      continue;
+
+    long solutions = s.mineSolutions.back();
+    for (int i = 0; i < last - first; i++) {
+      if (s.mineSolutions[i] == 0)
+        s.safe.push_back(s.frontier[first + i].cell);
+      else if (s.mineSolutions[i] == solutions)
+        s.mines.push_back(s.frontier[first + i].cell);
+    }
+  }
+  return !s.safe.empty() || !s.mines.empty();
+}
+
+static bool globalRule(SolverScratch& s,
+                       const GameState& state,
+                       int hiddenTotal) {
+  int remainingMines = state.bombCount - state.flagCount;
+  if (hiddenTotal == 0 ||
+      (remainingMines != 0 && remainingMines != hiddenTotal))
+    return false;
+  for (int r = 1; r <= state.rows; r++)
+    for (int c = 1; c <= state.cols; c++) {
+      int index = cellIndex(state, r, c);
+      if (isHidden(state.cells[index]))
+        (remainingMines == 0 ? s.safe : s.mines).push_back(index);
+    }
+  return true;
+}
+
+static void setOffsets(SolverScratch& s, int stride) {
+  int offset[8] = {-stride - 1, -stride, -stride + 1, -1,
+                   1, stride - 1, stride, stride + 1};
+  std::copy(offset, offset + 8, s.offset);
+}
+
+bool propagate(GameState& state) {
+  SolverScratch& s = scratch;
+  setOffsets(s, state.stride);
+  s.safe.clear();
+  s.mines.clear();
+  s.queue.clear();
+  s.active.clear();
+  s.constraints.clear();
+  s.frontier.clear();
+  s.queued.assign(state.cells.size(), 0);
+  s.inActive.assign(state.cells.size(), 0);
+  s.inFrontier.assign(state.cells.size(), 0);
+  s.constraintOf.assign(state.cells.size(), -1);
+  for (int r = 1; r <= state.rows; r++)
+    for (int c = 1; c <= state.cols; c++) {
+      int index = cellIndex(state, r, c);
+      s.queued[index] = 1;
+      s.queue.push_back(index);
+    }
+
+  while (true) {
+    if (!singleCellRules(s, state))
+      return false;
+    if (isWinState(state))
+      return true;
+
+    int hiddenTotal =
+        state.rows * state.cols - state.openedCount - state.flagCount;
+    buildConstraints(s, state);
+    if (!subsetRules(s, state) && !globalRule(s, state, hiddenTotal) &&
+        !componentRules(s, state, hiddenTotal))
+      return true;
+    if (!applyDeductions(s, state))
+      return false;
+  }
+}
+
+bool solveFromClick(GameState& state, int r, int c) {
+  if (!openPosition(state, r, c))
+    return false;
+  return propagate(state) && isWinState(state);
+}
+
+int genBoardNoGuess(GameState& state,
+                    int r,
+                    int c,
+                    uint64_t seed,
+                    RngKind kind,
+                    int maxAttempts,
+                    bool& solvable) {
+  static thread_local GameState attempt;
+  uint64_t attemptSeed = seed;
+  solvable = false;
+  int attempts = 0;
+  while (attempts < maxAttempts) {
+    attemptSeed = deriveSeed(seed, attempts++);
+    initBoard(attempt, state.rows, state.cols, state.bombCount);
+    attempt.noGuess = true;
+    genBoard(attempt, r, c, attemptSeed, kind);
+    if (solveFromClick(attempt, r, c)) {
+      solvable = true;
+      break;
+    }
+  }
+
+  state.noGuess = true;
+  genBoard(state, r, c, attemptSeed, kind);
+  return attempts;
+}
+
+// The numbers touching one frontier cell, as seen by the counting pass.
+struct CellStep {
+  int count;
+  int slot[8], mines[8], left[8];
+};
+
+enum TallyKind { TALLY_EXACT, TALLY_WEIGHTED, TALLY_SAMPLED };
+
+// How one frontier component can be filled. The component is walked cell by
+// cell; the state between two cells is how many mines each number with cells
+// on both sides has received so far, four bits per number, and next[d] maps
+// a state before cell d and the cell's value to the state after it.
+//
+// Exact tallies also count, for every state, the ways to fill the first d
+// cells by number of mines. Components too large for that are weighted:
+// each mine weighs the odds of a mine away from the frontier and only the
+// states are kept. Components with too many numbers open at once are
+// sampled, keeping how often each cell was a mine.
+struct ComponentTally {
+  TallyKind kind;
+  int cells;
+  size_t entries;
+  std::vector<double> solutions;            // by number of mines
+  std::vector<CellStep> steps;
+  std::vector<std::vector<int>> next;       // state * 2 + mine, or -1
+  std::vector<std::vector<double>> counts;  // state * (d + 1) + mines
+  std::vector<double> mines;                // cell * (cells + 1) + mines
+};
+
+// Components of earlier hint requests, keyed by their cells and numbers; a
+// move usually changes one or two components and leaves the rest cached.
+static thread_local std::unordered_map<uint64_t, ComponentTally> tallyCache;
+static thread_local size_t cachedEntries;
+
+// Like buildConstraints(), but from what the player sees: every opened
+// number, with flags treated as unopened cells since they may be wrong.
+static void buildHintConstraints(SolverScratch& s, const GameState& state) {
+  s.constraints.clear();
+  s.constraintOf.assign(state.cells.size(), -1);
+  for (int r = 1; r <= state.rows; r++)
+    for (int c = 1; c <= state.cols; c++) {
+      int index = cellIndex(state, r, c);
+      unsigned char cell = state.cells[index];
+      if (!(cell & CELL_OPENED) || (cell & CELL_MINE) ||
+          (cell & CELL_COUNT) == 0)
+        continue;
+
+      Constraint constraint;
+      constraint.cell = index;
+      constraint.r = r;
+      constraint.c = c;
+      constraint.mines = cell & CELL_COUNT;
+      constraint.count = 0;
+      constraint.window = 0;
+      for (int i = 0; i < 8; i++)
+        if (!(state.cells[index + s.offset[i]] & CELL_OPENED))
+          constraint.unknown[constraint.count++] = index + s.offset[i];
+      if (constraint.count == 0)
+        continue;
+      s.constraintOf[index] = s.constraints.size();
+      s.constraints.push_back(constraint);
+    }
+}
+
+static void recordSolution(SolverScratch& s,
+                           ComponentTally& tally,
+                           int placed) {
+  tally.solutions[placed]++;
+  for (int i = 0; i < tally.cells; i++)
+    if (s.assignment[i])
+      tally.mines[i * (tally.cells + 1) + placed]++;
+}
+
+static bool planSteps(SolverScratch& s, ComponentTally& tally, int first) {
+  tally.steps.resize(tally.cells);
+  for (int id : s.pending)
+    s.remaining[id] = -1;
+  uint64_t freeSlots = (1ULL << MAX_OPEN_NUMBERS) - 1;
+  for (int d = 0; d < tally.cells; d++) {
+    const FrontierCell& cell = s.frontier[first + d];
+    CellStep& step = tally.steps[d];
+    step.count = cell.count;
+    for (int i = 0; i < cell.count; i++) {
+      int id = cell.constraints[i];
+      if (s.remaining[id] < 0) {
+        if (!freeSlots)
+          return false;
+        s.remaining[id] = __builtin_ctzll(freeSlots);
+        s.unassigned[id] = s.constraints[id].count;
+        freeSlots &= freeSlots - 1;
+      }
+      step.slot[i] = s.remaining[id];
+      step.mines[i] = s.constraints[id].mines;
+      step.left[i] = --s.unassigned[id];
+    }
+    for (int i = 0; i < cell.count; i++)
+      if (step.left[i] == 0)
+        freeSlots |= 1ULL << step.slot[i];
+  }
+  return true;
+}
+
+typedef unsigned __int128 StateKey;
+
+static uint64_t hashKey(StateKey key) {
+  uint64_t state = (uint64_t)key ^ (uint64_t)(key >> 64) * 0x9e3779b97f4a7c15ULL;
+  return splitMix64(state);
+}
+
+static bool advance(const CellStep& step, StateKey& key, int mine) {
+  for (int i = 0; i < step.count; i++) {
+    int shift = 4 * step.slot[i];
+    int count = (int)(key >> shift & 15) + mine;
+    if (count > step.mines[i] || count + step.left[i] < step.mines[i])
+      return false;
+    key &= ~((StateKey)15 << shift);
+    if (step.left[i] > 0)
+      key |= (StateKey)count << shift;
+  }
+  return true;
+}
+
+static bool buildTransitions(ComponentTally& tally) {
+  tally.next.assign(tally.cells, std::vector<int>());
+  std::vector<StateKey> keys(1, 0), nextKeys;
+  // Open addressing from key hash to the state's index in nextKeys.
+  std::vector<int> table;
+  for (int d = 0; d < tally.cells; d++) {
+    std::vector<int>& next = tally.next[d];
+    next.assign(keys.size() * 2, -1);
+    tally.entries += next.size();
+    size_t mask = 1;
+    while (mask < next.size() * 2)
+      mask <<= 1;
+    table.assign(mask--, -1);
+    nextKeys.clear();
+    for (size_t state = 0; state < keys.size(); state++)
+      for (int mine = 0; mine <= 1; mine++) {
+        StateKey key = keys[state];
+        if (!advance(tally.steps[d], key, mine))
+          continue;
+        size_t slot = hashKey(key) & mask;
+        while (table[slot] >= 0 && nextKeys[table[slot]] != key)
+          slot = (slot + 1) & mask;
+        if (table[slot] < 0) {
+          table[slot] = nextKeys.size();
+          nextKeys.push_back(key);
+        }
+        next[state * 2 + mine] = table[slot];
+      }
+    if (tally.entries + nextKeys.size() * 2 > MAX_TRANSITIONS)
+      return false;
+    keys.swap(nextKeys);
+  }
+  return true;
+}
+
+static size_t layerStates(const ComponentTally& tally, int d) {
+  return d < tally.cells ? tally.next[d].size() / 2 : 1;
+}
+
+static bool countByMines(ComponentTally& tally) {
+  int cells = tally.cells;
+  size_t entries = 0;
+  for (int d = 0; d <= cells; d++)
+    entries += layerStates(tally, d) * (d + 1);
+  if (entries > MAX_TALLY_ENTRIES)
+    return false;
+
+  tally.entries += entries;
+  tally.counts.assign(cells + 1, std::vector<double>());
+  tally.counts[0].assign(1, 1);
+  for (int d = 0; d < cells; d++) {
+    const std::vector<double>& from = tally.counts[d];
+    std::vector<double>& to = tally.counts[d + 1];
+    const std::vector<int>& next = tally.next[d];
+    to.assign(layerStates(tally, d + 1) * (d + 2), 0);
+    for (size_t state = 0; state < next.size() / 2; state++)
+      for (int mine = 0; mine <= 1; mine++) {
+        int target = next[state * 2 + mine];
+        if (target < 0)
+          continue;
+        for (int k = 0; k <= d; k++)
+          to[target * (d + 2) + k + mine] += from[state * (d + 1) + k];
+      }
+  }
+  tally.solutions = tally.counts[cells];
+  return true;
+}
+
+// Weighted number of solutions of an exact tally with each cell mined and
+// with it clear, when the component holding k mines has relative weight
+// weight[k]: a backward pass gives the weighted ways to finish from every
+// state, which meet the forward counts at each cell.
+static void exactMarginals(const ComponentTally& tally,
+                           const std::vector<double>& weight,
+                           std::vector<double>& mined,
+                           std::vector<double>& clear) {
+  int cells = tally.cells;
+  mined.assign(cells, 0);
+  clear.assign(cells, 0);
+  std::vector<double> after(weight.begin(), weight.begin() + cells + 1),
+      before;
+  for (int d = cells - 1; d >= 0; d--) {
+    const std::vector<double>& forward = tally.counts[d];
+    const std::vector<int>& next = tally.next[d];
+    size_t states = next.size() / 2;
+    before.assign(states * (d + 1), 0);
+    for (size_t state = 0; state < states; state++)
+      for (int mine = 0; mine <= 1; mine++) {
+        int target = next[state * 2 + mine];
+        if (target < 0)
+          continue;
+        double& side = mine ? mined[d] : clear[d];
+        for (int k = 0; k <= d; k++) {
+          double ways = after[target * (d + 2) + k + mine];
+          before[state * (d + 1) + k] += ways;
+          side += forward[state * (d + 1) + k] * ways;
+        }
+      }
+    after.swap(before);
+  }
+}
+
+static void normalise(std::vector<double>& values) {
+  double top = values.empty()
+                   ? 0
+                   : *std::max_element(values.begin(), values.end());
+  if (top > 0)
+    for (double& value : values)
+      value /= top;
+}
+
+// The same passes for a weighted tally, where a mine weighs `odds` and the
+// mine count is not tracked. Layers are rescaled as they go; a cell's mined
+// and clear sides share the scale.
+static void weightedMarginals(const ComponentTally& tally,
+                              double odds,
+                              std::vector<double>& mined,
+                              std::vector<double>& clear) {
+  int cells = tally.cells;
+  mined.assign(cells, 0);
+  clear.assign(cells, 0);
+  std::vector<std::vector<double>> forward(cells + 1);
+  forward[0].assign(1, 1);
+  for (int d = 0; d < cells; d++) {
+    const std::vector<int>& next = tally.next[d];
+    forward[d + 1].assign(layerStates(tally, d + 1), 0);
+    for (size_t state = 0; state < next.size() / 2; state++)
+      for (int mine = 0; mine <= 1; mine++)
+        if (next[state * 2 + mine] >= 0)
+          forward[d + 1][next[state * 2 + mine]] +=
+              forward[d][state] * (mine ? odds : 1);
+    normalise(forward[d + 1]);
+  }
+
+  std::vector<double> after(1, 1), before;
+  for (int d = cells - 1; d >= 0; d--) {
+    const std::vector<int>& next = tally.next[d];
+    before.assign(next.size() / 2, 0);
+    for (size_t state = 0; state < next.size() / 2; state++)
+      for (int mine = 0; mine <= 1; mine++) {
+        int target = next[state * 2 + mine];
+        if (target < 0)
+          continue;
+        double ways = after[target] * (mine ? odds : 1);
+        before[state] += ways;
+        (mine ? mined[d] : clear[d]) += forward[d][state] * ways;
+      }
+    normalise(before);
+    after.swap(before);
+  }
+}
+
+// One randomised depth-first descent to a solution, trying a mine first
+// with the density its first number still needs. The descent is as deep as
+// the component is large, which on a big board is more than a server
+// session's stack holds, so it keeps its path in the scratch instead of
+// recursing.
+static bool sampleComponent(SolverScratch& s,
+                            ComponentTally& tally,
+                            Rng& rng,
+                            int first) {
+  int depth = 0, placed = 0;
+  bool found = false;
+  s.firstValue.resize(tally.cells);
+  s.triedValues.assign(tally.cells, 0);
+  while (true) {
+    if (depth == tally.cells) {
+      recordSolution(s, tally, placed);
+      found = true;
+      break;
+    }
+
+    const FrontierCell& cell = s.frontier[first + depth];
+    if (s.triedValues[depth] == 0) {
+      int k = cell.constraints[0];
+      s.firstValue[depth] =
+          (int)randomBelow(rng, s.unassigned[k]) < s.remaining[k] ? 1 : 0;
+    }
+    bool assigned = false;
+    while (s.triedValues[depth] < 2 && ++s.nodes <= MAX_SAMPLE_NODES) {
+      int mine = s.firstValue[depth] ^ s.triedValues[depth]++;
+      if (assignCell(s, cell, mine)) {
+        s.assignment[depth] = mine;
+        assigned = true;
+        break;
+      }
+    }
+    if (assigned) {
+      placed += s.assignment[depth++];
+      if (depth < tally.cells)
+        s.triedValues[depth] = 0;
+      continue;
+    }
+    if (depth == 0)
+      break;
+    depth--;
+    placed -= s.assignment[depth];
+    unassignCell(s, s.frontier[first + depth], s.assignment[depth]);
+  }
+
+  while (depth > 0) {
+    depth--;
+    unassignCell(s, s.frontier[first + depth], s.assignment[depth]);
+  }
+  return found;
+}
+
+static uint64_t componentKey(const SolverScratch& s,
+                             const GameState& state,
+                             int first,
+                             int last) {
+  uint64_t key = state.stride;
+  for (int i = first; i < last; i++)
+    key = splitMix64(key) ^ s.frontier[i].cell;
+  for (int id : s.pending)
+    key = splitMix64(key) ^ ((uint64_t)s.constraints[id].cell << 4 |
+                             s.constraints[id].mines);
+  return key;
+}
+
+static const ComponentTally& componentTally(SolverScratch& s,
+                                            const GameState& state,
+                                            int first,
+                                            int last) {
+  uint64_t key = componentKey(s, state, first, last);
+  auto cached = tallyCache.find(key);
+  if (cached != tallyCache.end())
+    return cached->second;
+
+  ComponentTally& tally = tallyCache[key];
+  tally.cells = last - first;
+  tally.entries = 0;
+  if (planSteps(s, tally, first) && buildTransitions(tally)) {
+    tally.kind = countByMines(tally) ? TALLY_EXACT : TALLY_WEIGHTED;
+  } else {
+    tally.kind = TALLY_SAMPLED;
+    tally.next.clear();
+    tally.solutions.assign(tally.cells + 1, 0);
+    tally.mines.assign((size_t)tally.cells * (tally.cells + 1), 0);
+    tally.entries = tally.mines.size();
+    for (int id : s.pending) {
+      s.remaining[id] = s.constraints[id].mines;
+      s.unassigned[id] = s.constraints[id].count;
+    }
+    s.assignment.assign(tally.cells, 0);
+    Rng rng;
+    seedRng(rng, key);
+    s.nodes = 0;
+    for (int sample = 0; sample < HINT_SAMPLES && s.nodes < MAX_SAMPLE_NODES;
+         sample++)
+      sampleComponent(s, tally, rng, first);
+  }
+  cachedEntries += tally.entries;
+  return tally;
+}
+
+// result[j] = sum of a[i] * b[j - i] for j <= limit, scaled to a maximum of
+// one; only ratios between entries matter to the probabilities.
+static void convolve(const std::vector<double>& a,
+                     const std::vector<double>& b,
+                     int limit,
+                     std::vector<double>& result) {
+  result.assign(std::min<size_t>(limit + 1, a.size() + b.size() - 1), 0);
+  for (size_t i = 0; i < a.size() && (int)i <= limit; i++)
+    if (a[i] != 0)
+      for (size_t j = 0; j < b.size() && (int)(i + j) <= limit; j++)
+        result[i + j] += a[i] * b[j];
+  double top = *std::max_element(result.begin(), result.end());
+  if (top > 0)
+    for (double& value : result)
+      value /= top;
+}
+
+void computeHints(const GameState& state, Hints& hints) {
+  SolverScratch& s = scratch;
+  setOffsets(s, state.stride);
+  hints.probability.assign(state.cells.size(), -1);
+  hints.safe.clear();
+  hints.mines.clear();
+  hints.exact = true;
+  static std::atomic<uint64_t> versions;
+  hints.version = ++versions;
+
+  buildHintConstraints(s, state);
+  s.frontier.clear();
+  s.inFrontier.assign(state.cells.size(), 0);
+  s.visited.assign(s.constraints.size(), 0);
+  s.remaining.resize(s.constraints.size());
+  s.unassigned.resize(s.constraints.size());
+  for (int id = 0; id < (int)s.constraints.size(); id++) {
+    s.remaining[id] = s.constraints[id].mines;
+    s.unassigned[id] = s.constraints[id].count;
+  }
+
+  if (cachedEntries > MAX_CACHED_ENTRIES) {
+    tallyCache.clear();
+    cachedEntries = 0;
+  }
+  std::vector<const ComponentTally*> tallies;
+  std::vector<int> firsts;
+  for (int id = 0; id < (int)s.constraints.size(); id++) {
+    if (s.visited[id])
+      continue;
+    int first = s.frontier.size();
+    collectComponent(s, id);
+
+    // Restarting from the number found last gives a sweep from one end of
+    // the component, which keeps few numbers open at a time.
+    int far = s.pending.back();
+    for (int other : s.pending)
+      s.visited[other] = 0;
+    for (size_t i = first; i < s.frontier.size(); i++)
+      s.inFrontier[s.frontier[i].cell] = 0;
+    s.frontier.resize(first);
+    collectComponent(s, far);
+    tallies.push_back(&componentTally(s, state, first, s.frontier.size()));
+    firsts.push_back(first);
+    hints.exact = hints.exact && tallies.back()->kind == TALLY_EXACT;
+  }
+
+  int count = tallies.size();
+  int mines = state.bombCount;
+  int unopened = state.rows * state.cols - state.openedCount;
+  int interior = unopened - (int)s.frontier.size();
+
+  // Weighted components take the overall mine density and then count as
+  // holding their expected number of mines.
+  double density = std::min(std::max((double)mines / unopened, 1e-6), 1 - 1e-6);
+  std::vector<std::vector<double>> distribution(count), weightedMined(count),
+      weightedClear(count);
+  for (int i = 0; i < count; i++) {
+    const ComponentTally& tally = *tallies[i];
+    if (tally.kind != TALLY_WEIGHTED) {
+      distribution[i] = tally.solutions;
+      continue;
+    }
+    weightedMarginals(tally, density / (1 - density), weightedMined[i],
+                      weightedClear[i]);
+    double expected = 0;
+    for (int cell = 0; cell < tally.cells; cell++)
+      if (weightedMined[i][cell] > 0)
+        expected += weightedMined[i][cell] /
+                    (weightedMined[i][cell] + weightedClear[i][cell]);
+    distribution[i].assign(tally.cells + 1, 0);
+    distribution[i][(int)(expected + 0.5)] = 1;
+  }
+
+  // Components only interact through the total mine count: weigh each
+  // mine count of a component by the ways the other components and the
+  // cells away from the frontier can hold the remaining mines. That takes
+  // tables of every mine count the frontier cells before each component can
+  // hold, which is quadratic in the frontier; past a limit (a large board
+  // opened wide) each cell outside a component counts as mined with the
+  // overall density instead.
+  size_t entries = 0, frontierCells = 0;
+  for (int i = 0; i < count; i++) {
+    frontierCells += tallies[i]->cells;
+    entries += std::min<size_t>(frontierCells, mines) + 1;
+  }
+  bool approximate = entries > MAX_MINE_COUNT_ENTRIES;
+  if (approximate)
+    hints.exact = false;
+
+  std::vector<double> ways(approximate ? 0 : mines + 1, 0);
+  double top = -INFINITY;
+  for (int m = 0; !approximate && m <= std::min(mines, interior); m++)
+    top = std::max(top, lgamma(interior + 1.0) - lgamma(m + 1.0) -
+                            lgamma(interior - m + 1.0));
+  for (int m = 0; !approximate && m <= std::min(mines, interior); m++)
+    ways[m] = exp(lgamma(interior + 1.0) - lgamma(m + 1.0) -
+                  lgamma(interior - m + 1.0) - top);
+
+  // before[i][m]: ways for the components before i to hold m mines.
+  // after[i][j]: ways for component i onwards and the interior to hold
+  // mines - j mines. Only j up to the frontier cells before component i is
+  // ever looked up, which keeps both tables at the size of the frontier
+  // rather than the mine count on large boards.
+  std::vector<std::vector<double>> before(count + 1), after(count + 1);
+  before[0].assign(1, 1);
+  for (int i = 0; i < count && !approximate; i++)
+    convolve(before[i], distribution[i], mines, before[i + 1]);
+  after[count].resize(before[count].size());
+  for (size_t j = 0; j < after[count].size(); j++)
+    after[count][j] = ways[mines - j];
+  for (int i = count - 1; i >= 0 && !approximate; i--) {
+    const std::vector<double>& next = after[i + 1];
+    after[i].assign(before[i].size(), 0);
+    for (size_t j = 0; j < after[i].size(); j++)
+      for (size_t k = 0; k < distribution[i].size() && j + k < next.size();
+           k++)
+        after[i][j] += distribution[i][k] * next[j + k];
+    double top = *std::max_element(after[i].begin(), after[i].end());
+    if (top > 0)
+      for (double& value : after[i])
+        value /= top;
+  }
+
+  double logOdds = log(density / (1 - density)), frontierMines = 0;
+  std::vector<double> weight, mined, clear;
+  for (int i = 0; i < count; i++) {
+    const ComponentTally& tally = *tallies[i];
+    weight.assign(tally.cells + 1, 0);
+    if (approximate) {
+      double solutions = 0, held = 0;
+      for (int k = 0; k <= tally.cells; k++) {
+        weight[k] = exp(k * logOdds - std::max(0.0, tally.cells * logOdds));
+        solutions += distribution[i][k] * weight[k];
+        held += distribution[i][k] * weight[k] * k;
+      }
+      if (solutions > 0)
+        frontierMines += held / solutions;
+    }
+    for (int k = 0; k <= tally.cells && k <= mines && !approximate; k++)
+      for (size_t other = 0; other < before[i].size(); other++)
+        if (other + k < after[i + 1].size())
+          weight[k] += before[i][other] * after[i + 1][other + k];
+
+    if (tally.kind == TALLY_EXACT) {
+      exactMarginals(tally, weight, mined, clear);
+    } else if (tally.kind == TALLY_WEIGHTED) {
+      mined.swap(weightedMined[i]);
+      clear.swap(weightedClear[i]);
+    } else {
+      mined.assign(tally.cells, 0);
+      clear.assign(tally.cells, 0);
+      for (int cell = 0; cell < tally.cells; cell++)
+        for (int k = 0; k <= tally.cells; k++) {
+          double hits = tally.mines[cell * (tally.cells + 1) + k];
+          mined[cell] += hits * weight[k];
+          clear[cell] += (tally.solutions[k] - hits) * weight[k];
+        }
+    }
+
+    for (int cell = 0; cell < tally.cells; cell++) {
+      double total = mined[cell] + clear[cell];
+      if (total <= 0) {
+        hints.exact = false;
+        continue;
+      }
+      int index = s.frontier[firsts[i] + cell].cell;
+      hints.probability[index] = mined[cell] / total;
+      CellPos pos = {index / state.stride, index % state.stride};
+      if (tally.kind != TALLY_SAMPLED && mined[cell] == 0)
+        hints.safe.push_back(pos);
+      else if (tally.kind != TALLY_SAMPLED && clear[cell] == 0)
+        hints.mines.push_back(pos);
+    }
+  }
+
+  double total = 0, expected = 0;
+  for (int k = 0; k < (int)before[count].size() && !approximate; k++) {
+    total += before[count][k] * ways[mines - k];
+    expected += before[count][k] * ways[mines - k] * (mines - k);
+  }
+  if (approximate) {
+    total = 1;
+    expected = std::min(std::max(mines - frontierMines, 0.0), (double)interior);
+  }
+  if (interior == 0 || total <= 0)
+    return;
+  double interiorProbability = expected / total / interior;
+  for (int r = 1; r <= state.rows; r++)
+    for (int c = 1; c <= state.cols; c++) {
+      int index = cellIndex(state, r, c);
+      if ((state.cells[index] & CELL_OPENED) || s.inFrontier[index])
+        continue;
+      hints.probability[index] = interiorProbability;
+      if (hints.exact && expected == 0)
+        hints.safe.push_back({r, c});
+      else if (hints.exact && expected == total * interior)
+        hints.mines.push_back({r, c});
+    }
+}
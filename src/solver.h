@@ -0,0 +1,61 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+#include <stdint.h>
+#include <vector>
+#include "game_controller.h"
+#include "rng.h"
+
+// Deterministic constraint solver working only from what a player can see:
+// opened numbers, flags and the total mine count. It never guesses.
+//
+// propagate() applies, until nothing changes:
+//  1. single-cell rules (a number whose flags or hidden neighbours account
+//     for all its mines),
+//  2. pairwise subset rules between numbers sharing hidden cells,
+//  3. exhaustive enumeration of small independent frontier components,
+//     keeping cells that are safe or mined in every solution,
+// opening proven safe cells and flagging proven mines through the engine.
+// Returns false only if an opened cell was a mine, which means the state had
+// a wrong flag to begin with.
+bool propagate(GameState& state);
+
+// Opens (r, c) on a generated board and propagates; true if the board was
+// cleared without guessing.
+bool solveFromClick(GameState& state, int r, int c);
+
+const int NO_GUESS_ATTEMPTS = 1000;
+
+// Generates boards from seeds derived from `seed` until one can be cleared
+// from (r, c) without guessing, at most maxAttempts times. The accepted board
+// is generated into `state` (its flags are kept) and state.seed records the
+// seed to rebuild it. Returns the number of attempts; `solvable` is false if
+// every attempt needed a guess, in which case the last one is used.
+int genBoardNoGuess(GameState& state,
+                    int r,
+                    int c,
+                    uint64_t seed,
+                    RngKind kind,
+                    int maxAttempts,
+                    bool& solvable);
+
+struct Hints {
+  // Mine probability of every unopened (or flagged) cell by cellIndex(), -1
+  // for opened cells.
+  std::vector<float> probability;
+  // Cells that are safe or mines in every arrangement consistent with the
+  // opened numbers and the mine count.
+  std::vector<CellPos> safe, mines;
+  // False if a large component was estimated by sampling.
+  bool exact;
+  // Distinct for every computeHints() result, so that what is derived from
+  // the hints can be cached.
+  uint64_t version;
+};
+
+// Works out hints from what the player can see; flags are not trusted.
+// The frontier is split into independent components that are enumerated
+// exactly (and remembered between calls) up to a size limit and sampled
+// beyond it, then combined through the total mine count.
+void computeHints(const GameState& state, Hints& hints);
+
+#endif
@@ -0,0 +1,96 @@
+#include "thread_pool.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct WorkRange {
+  std::mutex mutex;
+  long begin, end;
+};
+
+static bool takeFront(WorkRange& range, long grain, long& begin, long& end) {
+  std::lock_guard<std::mutex> lock(range.mutex);
+  if (range.begin >= range.end)
+    return false;
+  begin = range.begin;
+  end = std::min(range.end, begin + grain);
+  range.begin = end;
+  return true;
+}
+
+static bool steal(std::vector<std::unique_ptr<WorkRange>>& ranges,
+                  int thief,
+                  long grain) {
+  while (true) {
+    int victim = -1;
+    long most = 0;
+    for (int i = 0; i < (int)ranges.size(); i++) {
+      if (i == thief)
+        continue;
+      std::lock_guard<std::mutex> lock(ranges[i]->mutex);
+      long remaining = ranges[i]->end - ranges[i]->begin;
+      if (remaining > most) {
+        most = remaining;
+        victim = i;
+      }
+    }
+    if (victim < 0)
+      return false;
+
+    long begin, end;
+    {
+      std::lock_guard<std::mutex> lock(ranges[victim]->mutex);
+      long remaining = ranges[victim]->end - ranges[victim]->begin;
+      if (remaining <= 0)
+        continue;
+      long stolen = remaining > grain ? remaining / 2 : remaining;
+      end = ranges[victim]->end;
+      begin = end - stolen;
+      ranges[victim]->end = begin;
+    }
+
+    std::lock_guard<std::mutex> lock(ranges[thief]->mutex);
+    ranges[thief]->begin = begin;
+    ranges[thief]->end = end;
+    return true;
+  }
+}
+
+void parallelFor(long count,
+                 int threads,
+                 long grain,
+                 const std::function<void(int worker, long begin, long end)>&
+                     body) {
+  threads = std::max(1, threads);
+  grain = std::max(1L, grain);
+
+  std::vector<std::unique_ptr<WorkRange>> ranges;
+  for (int i = 0; i < threads; i++) {
+    ranges.emplace_back(new WorkRange);
+    ranges[i]->begin = count * i / threads;
+    ranges[i]->end = count * (i + 1) / threads;
+  }
+
+  auto worker = [&](int id) {
+    long begin, end;
+    while (true) {
+      if (takeFront(*ranges[id], grain, begin, end))
+        body(id, begin, end);
+      else if (!steal(ranges, id, grain))
+        return;
+    }
+  };
+
+  std::vector<std::thread> pool;
+  for (int i = 1; i < threads; i++)
+    pool.emplace_back(worker, i);
+  worker(0);
+  for (std::thread& thread : pool)
+    thread.join();
+}
+
+int defaultThreadCount() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
@@ -0,0 +1,17 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <functional>
+
+// Runs body(worker, begin, end) over [0, count) on `threads` workers. Every
+// worker starts with an equal slice and takes `grain` items at a time from
+// its front; a worker that runs dry steals the back half of the largest
+// remaining slice, so uneven item costs still keep all threads busy.
+void parallelFor(long count,
+                 int threads,
+                 long grain,
+                 const std::function<void(int worker, long begin, long end)>&
+                     body);
+
+int defaultThreadCount();
+
+#endif
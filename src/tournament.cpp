@@ -0,0 +1,85 @@
+#include "tournament.h"
+#include <stdio.h>
+#include <algorithm>
+#include <chrono>
+#include "bot.h"
+#include "metrics.h"
+#include "thread_pool.h"
+
+static TournamentResult playCorpus(const TournamentOptions& options,
+                                   int threads,
+                                   const BotInfo& info) {
+  std::vector<std::vector<int64_t>> latencies(threads);
+  std::vector<long> wins(threads, 0), resigned(threads, 0), moves(threads, 0),
+      decisions(threads, 0);
+  auto start = std::chrono::steady_clock::now();
+  parallelFor(options.games, threads, 64, [&](int worker, long begin,
+                                              long end) {
+    std::unique_ptr<BotStrategy> strategy = info.create();
+    for (long i = begin; i < end; i++) {
+      Game game(options.rows, options.cols, options.mines);
+      BotResult result = playBot(game, *strategy, deriveSeed(options.seed, i),
+                                 &latencies[worker]);
+      wins[worker] += result.status == GAME_WON;
+      resigned[worker] += result.status == GAME_PLAYING;
+      moves[worker] += result.moves;
+      decisions[worker] += result.decisions;
+    }
+  });
+
+  TournamentResult result = {info.name, options.games, 0, 0, 0, 0};
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  std::vector<int64_t> all;
+  for (int i = 0; i < threads; i++) {
+    result.wins += wins[i];
+    result.resigned += resigned[i];
+    result.moves += moves[i];
+    result.decisions += decisions[i];
+    all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+    std::vector<int64_t>().swap(latencies[i]);
+  }
+  std::sort(all.begin(), all.end());
+  result.p50 = percentile(all, 0.5);
+  result.p90 = percentile(all, 0.9);
+  result.p99 = percentile(all, 0.99);
+  result.p999 = percentile(all, 0.999);
+  result.max = all.empty() ? 0 : all.back() / 1000.0;
+  return result;
+}
+
+std::vector<TournamentResult> runTournament(const TournamentOptions& options) {
+  int threads = options.threads > 0 ? options.threads : defaultThreadCount();
+  std::vector<TournamentResult> results;
+  if (options.strategies.empty()) {
+    for (const BotInfo& info : botStrategies())
+      results.push_back(playCorpus(options, threads, info));
+  } else {
+    for (const char* name : options.strategies)
+      results.push_back(playCorpus(options, threads, *findBotStrategy(name)));
+  }
+  return results;
+}
+
+void printTournamentReport(const TournamentOptions& options,
+                           const std::vector<TournamentResult>& results) {
+  printf("board:   %dx%d, %d mines\n", options.rows, options.cols,
+         options.mines);
+  printf("seed:    %llu\n", (unsigned long long)options.seed);
+  printf("threads: %d\n",
+         options.threads > 0 ? options.threads : defaultThreadCount());
+  printf("games:   %ld per strategy\n\n", options.games);
+  printf("%-10s %8s %8s %10s %10s %10s  %s\n", "strategy", "win rate",
+         "resigned", "games/s", "moves/s", "moves/game",
+         "decision (us): p50 p90 p99 p99.9 max");
+  for (const TournamentResult& result : results) {
+    double seconds = result.seconds > 0 ? result.seconds : 1e-9;
+    printf("%-10s %7.2f%% %8ld %10.0f %10.0f %10.1f  %.1f %.1f %.1f %.1f %.1f\n",
+           result.strategy,
+           result.games ? 100.0 * result.wins / result.games : 0.0,
+           result.resigned, result.games / seconds, result.moves / seconds,
+           result.games ? (double)result.moves / result.games : 0.0,
+           result.p50, result.p90, result.p99, result.p999, result.max);
+  }
+}
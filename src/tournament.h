@@ -0,0 +1,28 @@
+#ifndef TOURNAMENT_H
+#define TOURNAMENT_H
+#include <stdint.h>
+#include <vector>
+
+struct TournamentOptions {
+  long games;
+  int rows, cols, mines, threads;
+  // Game i is played on the board of deriveSeed(seed, i) by every strategy.
+  uint64_t seed;
+  // botStrategies() names; all of them if empty.
+  std::vector<const char*> strategies;
+};
+
+struct TournamentResult {
+  const char* strategy;
+  long games, wins, resigned, moves, decisions;
+  double seconds;
+  // Time spent in decide(), in microseconds.
+  double p50, p90, p99, p999, max;
+};
+
+// Plays the whole corpus with each strategy in turn, on all threads.
+std::vector<TournamentResult> runTournament(const TournamentOptions& options);
+void printTournamentReport(const TournamentOptions& options,
+                           const std::vector<TournamentResult>& results);
+
+#endif
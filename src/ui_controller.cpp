@@ -1,9 +1,51 @@
 #include "ui_controller.h"
 #include <ctype.h>
+#include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <algorithm>
+#include <chrono>
+#include <vector>
+#include "analysis.h"
+#include "metrics.h"
+
+static Terminal console;
+static Terminal* term = &console;
+static std::chrono::steady_clock::duration frameInterval =
+    std::chrono::microseconds(1000000 / DEFAULT_FPS);
+
+// Every flush is one frame, bracketed in synchronised output (DEC mode 2026)
+// so terminals that support it show it at once; others ignore the mode.
+static const char FRAME_BEGIN[] = "\x1b[?2026h";
+static const char FRAME_END[] = "\x1b[?2026l";
+
+Terminal* setTerminal(Terminal* terminal) {
+  Terminal* previous = term;
+  term = terminal ? terminal : &console;
+  return previous;
+}
+
+void setFrameRate(int fps) {
+  frameInterval = fps > 0 ? std::chrono::steady_clock::duration(
+                                std::chrono::microseconds(1000000 / fps))
+                          : std::chrono::steady_clock::duration::zero();
+}
+
+void runWork(const std::function<void()>& work) {
+  if (term->runWork)
+    term->runWork(term->session, work);
+  else
+    work();
+}
+
+// Stamps the first input that the next flush answers, for METRIC_INPUT_LATENCY.
+static int noteInput(int events) {
+  if (METRICS_ENABLED && (events & EVENT_INPUT) && !term->inputTime)
+    term->inputTime = metricsClock();
+  return events;
+}
 
 #ifdef _WIN32
 
@@ -18,7 +60,8 @@ void initConsole() {
   GetConsoleMode(hInput, &idwMode);
   GetConsoleMode(hOutput, &odwMode);
 
-  idwMode = ENABLE_PROCESSED_INPUT | ENABLE_EXTENDED_FLAGS | ENABLE_MOUSE_INPUT;
+  idwMode = ENABLE_PROCESSED_INPUT | ENABLE_EXTENDED_FLAGS |
+            ENABLE_MOUSE_INPUT | ENABLE_WINDOW_INPUT;
   odwMode |= ENABLE_PROCESSED_OUTPUT | ENABLE_VIRTUAL_TERMINAL_PROCESSING;
 
   SetConsoleMode(hInput, idwMode);
@@ -44,6 +87,73 @@ void getConsoleWidthHeight(int& width, int& height) {
   height = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
 }
 
+static std::chrono::steady_clock::time_point nextTick =
+    std::chrono::steady_clock::now() + std::chrono::seconds(1);
+static int waitWidth = -1, waitHeight = -1;
+
+void resetTimer() {
+  nextTick = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+}
+
+// Console writes complete synchronously, so only the frame rate applies.
+bool frameReady() {
+  return std::chrono::steady_clock::now() >= term->nextFrame;
+}
+
+int waitForEvents(int mask) {
+  HANDLE hInput = GetStdHandle(STD_INPUT_HANDLE);
+  while (true) {
+    if ((mask & EVENT_FRAME) && frameReady())
+      return EVENT_FRAME;
+
+    DWORD timeout = INFINITE;
+    auto now = std::chrono::steady_clock::now();
+    if (mask & EVENT_TIMER) {
+      timeout = nextTick > now
+                    ? (DWORD)std::chrono::duration_cast<
+                          std::chrono::milliseconds>(nextTick - now)
+                          .count()
+                    : 0;
+    }
+    if (mask & EVENT_FRAME)
+      timeout = std::min(timeout,
+                         (DWORD)std::chrono::ceil<std::chrono::milliseconds>(
+                             term->nextFrame - now)
+                             .count());
+
+    // Resize notifications arrive as WINDOW_BUFFER_SIZE_EVENT records, so the
+    // input handle is signalled for them as well.
+    DWORD result = WaitForSingleObject(hInput, timeout);
+
+    int events = 0;
+    int width, height;
+    getConsoleWidthHeight(width, height);
+    if (width != waitWidth || height != waitHeight) {
+      waitWidth = width;
+      waitHeight = height;
+      events |= EVENT_RESIZE;
+    }
+    if (result == WAIT_OBJECT_0) {
+      events |= EVENT_INPUT;
+    } else if (result == WAIT_TIMEOUT && (mask & EVENT_TIMER) &&
+               std::chrono::steady_clock::now() >= nextTick) {
+      events |= EVENT_TIMER;
+      nextTick += std::chrono::seconds(1);
+    }
+
+    if (events & mask)
+      return noteInput(events & mask);
+
+    // Drain records nobody is waiting for, otherwise the handle stays
+    // signalled and the wait degenerates into a spin.
+    if (result == WAIT_OBJECT_0 && !(mask & EVENT_INPUT)) {
+      INPUT_RECORD record;
+      DWORD cNumRead;
+      ReadConsoleInput(hInput, &record, 1, &cNumRead);
+    }
+  }
+}
+
 int getInput() {
   int ch = -1;
   if (kbhit()) {
@@ -93,22 +203,91 @@ bool getMouseInput(int& r, int& c, int& event) {
   return true;
 }
 
+bool inputPending() {
+  return false;
+}
+
 #else
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
 #include <sys/ioctl.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/timerfd.h>
+#endif
+
+static int resizePipe[2] = {-1, -1};
+static int timerFd = -1;
+
+static void onResize(int) {
+  int savedErrno = errno;
+  char byte = 0;
+  if (write(resizePipe[1], &byte, 1) < 0) {
+    // The pipe is full, so a wakeup is already pending.
+  }
+  errno = savedErrno;
+}
+
+static void drainFd(int fd) {
+  char buffer[64];
+  while (read(fd, buffer, sizeof buffer) > 0) {
+  }
+}
+
+static void queryConsoleSize() {
+  struct winsize w;
+  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0) {
+    console.width = w.ws_col;
+    console.height = w.ws_row;
+  }
+}
 
 void initConsole() {
   termios term;
   tcgetattr(0, &term);
   term.c_lflag &= ~(ICANON | ECHO);
   tcsetattr(0, TCSANOW, &term);
+
+  if (pipe(resizePipe) == 0) {
+    for (int fd : resizePipe) {
+      fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+      fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof action);
+    action.sa_handler = onResize;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGWINCH, &action, nullptr);
+  }
+
+#ifdef __linux__
+  timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+#endif
+  resetTimer();
+
+  queryConsoleSize();
+  setMouseReporting(true);
   clearScreen(40);
 }
 
 void closeConsole() {
+  setMouseReporting(false);
   clearScreen(0);
+  signal(SIGWINCH, SIG_DFL);
+  for (int& fd : resizePipe) {
+    if (fd >= 0)
+      close(fd);
+    fd = -1;
+  }
+  if (timerFd >= 0)
+    close(timerFd);
+  timerFd = -1;
   termios term;
   tcgetattr(0, &term);
   term.c_lflag |= ICANON | ECHO;
@@ -129,73 +308,412 @@ int getch() {
   return retcode <= 0 ? EOF : (int)ch;
 }
 
-static int getchs(char* buffer) {
-  return read(STDIN_FILENO, buffer, 8);
+void getConsoleWidthHeight(int& width, int& height) {
+  if (!term->session && term->width < 0)
+    queryConsoleSize();
+
+  width = term->width;
+  height = term->height;
 }
 
-void getConsoleWidthHeight(int& width, int& height) {
-  struct winsize w;
-  ioctl(STDOUT_FILENO, TIOCGWINSZ, &w);
+void resetTimer() {
+  term->nextTick = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+#ifdef __linux__
+  if (!term->session && timerFd >= 0) {
+    itimerspec spec;
+    spec.it_interval.tv_sec = 1;
+    spec.it_interval.tv_nsec = 0;
+    spec.it_value = spec.it_interval;
+    timerfd_settime(timerFd, 0, &spec, nullptr);
+  }
+#endif
+}
 
-  width = w.ws_col;
-  height = w.ws_row;
+bool frameReady() {
+  if (std::chrono::steady_clock::now() < term->nextFrame)
+    return false;
+  if (term->session)
+    return !term->outputBusy(term->session);
+  pollfd fd = {STDOUT_FILENO, POLLOUT, 0};
+  return poll(&fd, 1, 0) != 0;
 }
 
-int getInput() {
-  if (!kbhit())
-    return -1;
+static int millisecondsUntil(std::chrono::steady_clock::time_point time) {
+  auto now = std::chrono::steady_clock::now();
+  return time > now
+             ? (int)std::chrono::ceil<std::chrono::milliseconds>(time - now)
+                   .count()
+             : 0;
+}
 
-  char buffer[8];
-  int bytes = getchs(buffer);
+// Input is read into the terminal's byte ring, everything pending in one
+// call, and decoded into its event ring. An escape sequence split across
+// reads waits up to ESC_DELAY_MS for the rest on the console; one that stays
+// incomplete, such as a lone ESC key, is taken as ESC followed by plain keys.
+const int ESC_DELAY_MS = 20;
 
-  if (bytes <= 0)
-    return -1;
+static size_t queuedEvents() {
+  return term->eventTail - term->eventHead;
+}
+
+static unsigned char inputByte(size_t offset) {
+  return term->inputBytes[(term->inputHead + offset) % INPUT_BYTES];
+}
 
-  if (bytes == 1)
-    return tolower(buffer[0]);
+static void queueEvent(int key, int mouse, int r, int c) {
+  term->inputEvents[term->eventTail++ % INPUT_EVENTS] = {key, mouse, r, c};
+}
+
+// Reads the decimal number at `offset`, moving past it and one separator.
+static int sequenceNumber(size_t& offset, size_t end) {
+  int value = 0;
+  while (offset < end && isdigit(inputByte(offset)) && value < 100000)
+    value = value * 10 + inputByte(offset++) - '0';
+  if (offset < end)
+    offset++;
+  return value;
+}
 
-  if (bytes == 3 && buffer[0] == KEY_ESC && buffer[1] == 91)
-    return buffer[2];
+// ESC [ ... final or ESC O final, with the final byte at `end`.
+static void decodeSequence(size_t end) {
+  unsigned char final = inputByte(end);
+  bool arrow = final >= 'A' && final <= 'D';
+  if (inputByte(1) == 'O' || end == 2) {
+    queueEvent(final, -1, 0, 0);
+    return;
+  }
+  if (inputByte(2) == '<' && (final == 'M' || final == 'm')) {
+    // SGR mouse report: ESC [ < button ; column ; row, M on press and
+    // motion, m on release.
+    size_t offset = 3;
+    int button = sequenceNumber(offset, end);
+    int c = sequenceNumber(offset, end), r = sequenceNumber(offset, end);
+    int mouse = -1;
+    if (button & 64)
+      mouse = -1;  // wheel
+    else if (button & 32)
+      mouse = 0;
+    else if (final == 'M' && (button & 3) == 0)
+      mouse = 1;
+    else if (final == 'M' && (button & 3) == 2)
+      mouse = 2;
+    if (mouse >= 0 && r > 0 && c > 0)
+      queueEvent(-1, mouse, r, c);
+  } else if (arrow) {
+    // Arrows with modifiers (ESC [ 1 ; 5 A) move like plain ones.
+    queueEvent(final, -1, 0, 0);
+  }
+}
 
+// Decodes buffered bytes into events until one or the other runs out. With
+// `flush`, a trailing incomplete sequence is decoded as plain bytes instead
+// of waiting for the rest.
+static void decodeInput(bool flush) {
+  while (term->inputHead != term->inputTail && queuedEvents() < INPUT_EVENTS) {
+    size_t available = term->inputTail - term->inputHead;
+    unsigned char first = inputByte(0);
+    size_t used = 1;
+    if (first != KEY_ESC) {
+      // Multi-byte characters have no meaning to the game.
+      if (first < 0x80)
+        queueEvent(tolower(first), -1, 0, 0);
+    } else if (available > 1 &&
+               (inputByte(1) == '[' || inputByte(1) == 'O')) {
+      // Parameter and intermediate bytes, then the final byte.
+      size_t end = 2;
+      if (inputByte(1) == '[')
+        while (end < available && inputByte(end) >= 0x20 &&
+               inputByte(end) < 0x40)
+          end++;
+      if (end == available && !flush)
+        return;
+      if (end < available && inputByte(end) >= 0x40 && inputByte(end) < 0x7f) {
+        decodeSequence(end);
+        used = end + 1;
+      } else {
+        queueEvent(KEY_ESC, -1, 0, 0);
+      }
+    } else {
+      if (available == 1 && !flush)
+        return;
+      queueEvent(KEY_ESC, -1, 0, 0);
+    }
+    term->inputHead += used;
+  }
+}
+
+// Moves what is pending into the byte ring in one call; false at end of file.
+static bool readInput() {
+  size_t free = INPUT_BYTES - (term->inputTail - term->inputHead);
+  size_t tail = term->inputTail % INPUT_BYTES;
+  size_t first = std::min(free, INPUT_BYTES - tail);
+  if (!free)
+    return true;
+  if (term->session) {
+    int bytes =
+        term->readInput(term->session, (char*)term->inputBytes + tail, first);
+    if (bytes == (int)first && free > first)
+      bytes += term->readInput(term->session, (char*)term->inputBytes,
+                               free - first);
+    term->inputTail += bytes;
+    return true;
+  }
+  iovec parts[2] = {{term->inputBytes + tail, first},
+                    {term->inputBytes, free - first}};
+  ssize_t bytes = readv(STDIN_FILENO, parts, free > first ? 2 : 1);
+  if (bytes < 0)
+    return errno == EINTR || errno == EAGAIN;
+  term->inputTail += bytes;
+  return bytes > 0;
+}
+
+// Reads and decodes what has arrived; false at end of file.
+static bool fetchInput() {
+  bool open = readInput();
+  decodeInput(term->session != nullptr);
+  if (!term->session && term->inputHead != term->inputTail &&
+      queuedEvents() < INPUT_EVENTS) {
+    pollfd fd = {STDIN_FILENO, POLLIN, 0};
+    if (poll(&fd, 1, ESC_DELAY_MS) > 0)
+      open = readInput();
+    decodeInput(true);
+  }
+  return open;
+}
+
+bool inputPending() {
+  decodeInput(true);
+  return queuedEvents() > 0;
+}
+
+int waitForEvents(int mask) {
+  if ((mask & EVENT_INPUT) && inputPending())
+    return noteInput(EVENT_INPUT);
+
+  if (term->session) {
+    while (true) {
+      int events = term->waitEvents(term->session, mask);
+      if ((events & EVENT_INPUT) && (fetchInput(), !queuedEvents()))
+        events &= ~EVENT_INPUT;
+      if (events)
+        return noteInput(events);
+    }
+  }
+
+  while (true) {
+    pollfd fds[4];
+    int events[4];
+    int count = 0;
+    if (mask & EVENT_INPUT) {
+      fds[count] = {STDIN_FILENO, POLLIN, 0};
+      events[count++] = EVENT_INPUT;
+    }
+    if ((mask & EVENT_RESIZE) && resizePipe[0] >= 0) {
+      fds[count] = {resizePipe[0], POLLIN, 0};
+      events[count++] = EVENT_RESIZE;
+    }
+    if ((mask & EVENT_TIMER) && timerFd >= 0) {
+      fds[count] = {timerFd, POLLIN, 0};
+      events[count++] = EVENT_TIMER;
+    }
+
+    int timeout = -1;
+    if ((mask & EVENT_TIMER) && timerFd < 0)
+      timeout = millisecondsUntil(term->nextTick);
+    if (mask & EVENT_FRAME) {
+      int frameTimeout = millisecondsUntil(term->nextFrame);
+      if (frameTimeout == 0) {
+        fds[count] = {STDOUT_FILENO, POLLOUT, 0};
+        events[count++] = EVENT_FRAME;
+      } else if (timeout < 0 || frameTimeout < timeout) {
+        timeout = frameTimeout;
+      }
+    }
+
+    int ready = poll(fds, count, timeout);
+    if (ready < 0) {
+      if (errno == EINTR)
+        continue;
+      return 0;
+    }
+
+    int result = 0;
+    if ((mask & EVENT_TIMER) && timerFd < 0 &&
+        std::chrono::steady_clock::now() >= term->nextTick) {
+      term->nextTick += std::chrono::seconds(1);
+      result |= EVENT_TIMER;
+    }
+    for (int i = 0; i < count; i++) {
+      if (!(fds[i].revents & (POLLIN | POLLOUT | POLLHUP | POLLERR | POLLNVAL)))
+        continue;
+      if (events[i] == EVENT_RESIZE) {
+        drainFd(resizePipe[0]);
+        queryConsoleSize();
+      } else if (events[i] == EVENT_TIMER) {
+        drainFd(timerFd);
+      } else if (events[i] == EVENT_INPUT) {
+        // Bytes that decode to nothing yet (or at all) are not input. At end
+        // of file stdin stays readable, so once the last keys are handled
+        // the game is unwound rather than polled forever.
+        bool open = !(fds[i].revents & POLLNVAL) && fetchInput();
+        if (!open && !queuedEvents())
+          throw InputClosed();
+        if (!queuedEvents())
+          continue;
+      }
+      result |= events[i];
+    }
+
+    if (result)
+      return noteInput(result);
+  }
+}
+
+int getInput() {
+  term->mouseEvent.mouse = -1;
+  if (!inputPending())
+    return -1;
+  InputEvent event = term->inputEvents[term->eventHead++ % INPUT_EVENTS];
+  if (event.key >= 0)
+    return event.key;
+  term->mouseEvent = event;
   return -1;
 }
 
 bool getMouseInput(int& r, int& c, int& event) {
-  return false;
+  if (term->mouseEvent.mouse < 0)
+    return false;
+  r = term->mouseEvent.r;
+  c = term->mouseEvent.c;
+  event = term->mouseEvent.mouse;
+  term->mouseEvent.mouse = -1;
+  return true;
 }
 
 #endif
 
-int lastWidth = -1;
-int lastHeight = -1;
+struct CellGlyph {
+  int color;
+  bool reverse;
+  const char* glyph;
+};
+
+const CellGlyph glyphs[] = {
+    {97, false, " "}, {94, false, "𝟏"}, {32, false, "𝟐"}, {91, false, "𝟑"},
+    {34, false, "𝟒"}, {31, false, "𝟓"}, {36, false, "𝟔"}, {30, false, "𝟕"},
+    {37, false, "𝟖"}, {97, false, "■"}, {93, false, "⚑"}, {95, false, "*"},
+    {93, true, "⚑"},
+    // Hint overlay: safe, certain mine, then low, medium and high odds.
+    {92, false, "○"}, {91, false, "×"}, {32, false, "░"}, {33, false, "▒"},
+    {31, false, "▓"}};
+
+const unsigned char HINT_SAFE = 13, HINT_MINE = 14, HINT_LOW = 15,
+                    HINT_MEDIUM = 16, HINT_HIGH = 17;
+
+static void reserveOutput(size_t size) {
+  if (size <= term->out.size())
+    return;
+  term->out.resize(std::max(size, 2 * term->out.size()));
+}
+
+static void beginFrame() {
+  if (term->outSize)
+    return;
+  reserveOutput(sizeof FRAME_BEGIN - 1);
+  memcpy(term->out.data(), FRAME_BEGIN, sizeof FRAME_BEGIN - 1);
+  term->outSize = sizeof FRAME_BEGIN - 1;
+}
+
+static void emitBytes(const char* bytes, size_t size) {
+  beginFrame();
+  reserveOutput(term->outSize + size);
+  memcpy(term->out.data() + term->outSize, bytes, size);
+  term->outSize += size;
+}
 
-char symbols[][32] = {
-    " ",         "\x1b[94m𝟏", "\x1b[32m𝟐",          "\x1b[91m𝟑", "\x1b[34m𝟒",
-    "\x1b[31m𝟓", "\x1b[36m𝟔", "\x1b[30m𝟕",          "\x1b[37m𝟖", "■",
-    "\x1b[93m⚑", "\x1b[95m*", "\x1b[7;93m⚑\x1b[27m"};
+static void emit(const char* fmt, ...) {
+  beginFrame();
+  reserveOutput(term->outSize + 256);
+  va_list args;
+  va_start(args, fmt);
+  int size = vsnprintf(term->out.data() + term->outSize,
+                       term->out.size() - term->outSize, fmt, args);
+  va_end(args);
+  if (size < 0)
+    return;
+  if ((size_t)size >= term->out.size() - term->outSize) {
+    reserveOutput(term->outSize + size + 1);
+    va_start(args, fmt);
+    vsnprintf(term->out.data() + term->outSize,
+              term->out.size() - term->outSize, fmt, args);
+    va_end(args);
+  }
+  term->outSize += size;
+}
+
+static void flushOutput() {
+  if (!term->outSize)
+    return;
+  reserveOutput(term->outSize + sizeof FRAME_END - 1);
+  memcpy(term->out.data() + term->outSize, FRAME_END, sizeof FRAME_END - 1);
+  term->outSize += sizeof FRAME_END - 1;
+  term->nextFrame = std::chrono::steady_clock::now() + frameInterval;
+#ifdef _WIN32
+  fwrite(term->out.data(), 1, term->outSize, stdout);
+  fflush(stdout);
+#else
+  if (term->session) {
+    term->writeOutput(term->session, term->out.data(), term->outSize);
+  } else {
+    size_t written = 0;
+    while (written < term->outSize) {
+      ssize_t result = write(STDOUT_FILENO, term->out.data() + written,
+                             term->outSize - written);
+      if (result < 0 && errno == EINTR)
+        continue;
+      if (result <= 0)
+        break;
+      written += result;
+    }
+  }
+#endif
+  term->outSize = 0;
+  if (METRICS_ENABLED && term->inputTime) {
+    recordElapsed(METRIC_INPUT_LATENCY, term->inputTime);
+    term->inputTime = 0;
+  }
+}
 
 void clearScreen(int mode) {
-  printf("\x1b[%d;97m", mode);
-  printf("\x1b[2J");
-  printf("\x1b[H");
+  emit("\x1b[%d;97m", mode);
+  emit("\x1b[2J");
+  emit("\x1b[H");
+  flushOutput();
+  term->screenDirty = true;
 }
 
 void clearScreenInline(int mode) {
-  printf("\x1b[%d;97m", mode);
-  int rows, cols;
-  getConsoleWidthHeight(cols, rows);
-  for (int r = 1; r <= rows; r++)
-    for (int c = 1; c <= cols; c++)
-      printf("\x1b[%d;%dH ", r, c);
-  printf("\x1b[H");
+  term->screenDirty = true;
+  emit("\x1b[%d;97m\x1b[2J\x1b[H", mode);
 }
 
 void hideCursor() {
-  printf("\x1b[?25l");
+  emit("\x1b[?25l");
+  flushOutput();
 }
 
 void showCursor() {
-  printf("\x1b[?25h");
+  emit("\x1b[?25h");
+  flushOutput();
+}
+
+void setMouseReporting(bool enabled) {
+#ifndef _WIN32
+  // Any-motion tracking (1003) so that hovering moves the cursor, reported in
+  // the SGR format (1006), which has no limit on coordinates.
+  emit(enabled ? "\x1b[?1003h\x1b[?1006h" : "\x1b[?1003l\x1b[?1006l");
+  flushOutput();
+#endif
 }
 
 static void assertScreenSize(int rows, int cols) {
@@ -205,29 +723,80 @@ static void assertScreenSize(int rows, int cols) {
     return;
 
   char msg[] = "Screen too small!";
+  term->screenDirty = true;
 
-  printf("\x1b[2J");
-  printf("\x1b\x1b[%d;%dH%s", (height - 1) / 2 + 1,
+  emit("\x1b[2J");
+  emit("\x1b\x1b[%d;%dH%s", (height - 1) / 2 + 1,
          (width - (int)strlen(msg)) / 2 + 1, msg);
-  fflush(stdout);
+  flushOutput();
 
   while (width < cols || height < rows) {
-    if (width != lastWidth || height != lastHeight) {
-      printf("\x1b[2J");
-      printf("\x1b\x1b[%d;%dH%s", (height - 1) / 2 + 1,
+    if (width != term->lastWidth || height != term->lastHeight) {
+      emit("\x1b[2J");
+      emit("\x1b\x1b[%d;%dH%s", (height - 1) / 2 + 1,
              (width - (int)strlen(msg)) / 2 + 1, msg);
-      fflush(stdout);
+      flushOutput();
     }
 
-    lastWidth = width;
-    lastHeight = height;
+    term->lastWidth = width;
+    term->lastHeight = height;
 
+    waitForEvents(EVENT_RESIZE);
     getConsoleWidthHeight(width, height);
   }
 }
 
-static char* cellToChar(int cell) {
-  return symbols[cell];
+// Where the board goes on screen: the border's top-left corner, the part of
+// the board inside it, and the minimap box to its right when the board is
+// larger than the terminal (minimapRows is 0 otherwise).
+struct BoardLayout {
+  int pos_r, pos_c;
+  int rows, cols;
+  int minimap_r, minimap_c, minimapRows;
+};
+
+const int MINIMAP_ROWS = 8, MINIMAP_COLS = 16;
+
+static void layoutBoard(const GameState& state, BoardLayout& layout) {
+  int consoleWidth, consoleHeight;
+  getConsoleWidthHeight(consoleWidth, consoleHeight);
+  layout.rows = std::max(1, std::min(state.rows, consoleHeight - 5));
+  layout.cols = std::max(1, std::min(state.cols, (consoleWidth - 3) / 2));
+  int minimapWidth = 0;
+  layout.minimapRows = 0;
+  if (layout.rows < state.rows || layout.cols < state.cols) {
+    minimapWidth = MINIMAP_COLS + 3;
+    layout.minimapRows = std::min(MINIMAP_ROWS, layout.rows);
+    layout.cols = std::max(
+        1, std::min(state.cols, (consoleWidth - 3 - minimapWidth) / 2));
+  }
+
+  int boardWidth = 2 * layout.cols - 1 + 4;
+  int boardHeight = layout.rows + 2;
+  layout.pos_r = (consoleHeight - boardHeight - 3) / 2 + 3;
+  layout.pos_c = (consoleWidth - boardWidth - minimapWidth) / 2 + 1;
+  layout.minimap_r = layout.pos_r;
+  layout.minimap_c = layout.pos_c + boardWidth + 1;
+}
+
+// Moves the view just enough to keep the cursor (if any) a couple of cells
+// away from its edges, then keeps it inside the board.
+static void scrollView(const GameState& state,
+                       const BoardLayout& layout,
+                       int cursor_r,
+                       int cursor_c) {
+  auto scroll = [](int& first, int visible, int size, int cursor) {
+    if (cursor >= 1) {
+      int margin = std::min(2, (visible - 1) / 2);
+      if (cursor < first + margin)
+        first = cursor - margin;
+      else if (cursor > first + visible - 1 - margin)
+        first = cursor - visible + 1 + margin;
+    }
+    first = std::max(1, std::min(first, size - visible + 1));
+  };
+  scroll(term->viewTop, layout.rows, state.rows, cursor_r);
+  scroll(term->viewLeft, layout.cols, state.cols, cursor_c);
 }
 
 bool screenToBoard(GameState& state,
@@ -235,71 +804,193 @@ bool screenToBoard(GameState& state,
                    int screen_c,
                    int& board_r,
                    int& board_c) {
-  int boardWidth = 2 * state.cols - 1 + 4;
-  int boardHeight = state.rows + 2;
-  int consoleWidth, consoleHeight;
-  getConsoleWidthHeight(consoleWidth, consoleHeight);
-  int pos_r = (consoleHeight - boardHeight - 3) / 2 + 3 + 1;
-  int pos_c = (consoleWidth - boardWidth) / 2 + 1 + 2;
+  BoardLayout layout;
+  layoutBoard(state, layout);
+  scrollView(state, layout, 0, 0);
+  int pos_r = layout.pos_r + 1;
+  int pos_c = layout.pos_c + 2;
 
-  if ((screen_r < pos_r) || (screen_r >= pos_r + state.rows))
+  if ((screen_r < pos_r) || (screen_r >= pos_r + layout.rows))
     return false;
-  if ((screen_c < pos_c) || (screen_c >= pos_c + 2 * state.cols - 1))
+  if ((screen_c < pos_c) || (screen_c >= pos_c + 2 * layout.cols - 1))
     return false;
 
   if ((screen_c - pos_c) % 2 != 0)
     return false;
 
-  board_r = screen_r - pos_r + 1;
-  board_c = (screen_c - pos_c) / 2 + 1;
+  board_r = screen_r - pos_r + term->viewTop;
+  board_c = (screen_c - pos_c) / 2 + term->viewLeft;
 
   return true;
 }
 
-static void printBoardBorder(int pos_r, int pos_c, int rows, int cols) {
-  printf("\x1b[%d;%dH", pos_r, pos_c + 1);
-  for (int i = 1; i <= 2 * cols + 1; i++)
-    printf("═");
-  printf("\x1b[%d;%dH", pos_r + rows + 1, pos_c + 1);
-  for (int i = 1; i <= 2 * cols + 1; i++)
-    printf("═");
+// A double-line box around `rows` x `width` characters.
+static void printBox(int pos_r, int pos_c, int rows, int width) {
+  emit("\x1b[%d;%dH", pos_r, pos_c + 1);
+  for (int i = 1; i <= width; i++)
+    emit("═");
+  emit("\x1b[%d;%dH", pos_r + rows + 1, pos_c + 1);
+  for (int i = 1; i <= width; i++)
+    emit("═");
   for (int i = pos_r + 1; i <= pos_r + rows; i++)
-    printf("\x1b[%d;%dH║", i, pos_c);
+    emit("\x1b[%d;%dH║", i, pos_c);
   for (int i = pos_r + 1; i <= pos_r + rows; i++)
-    printf("\x1b[%d;%dH║", i, pos_c + 2 * cols + 2);
+    emit("\x1b[%d;%dH║", i, pos_c + width + 1);
+
+  emit("\x1b[%d;%dH╔", pos_r, pos_c);
+  emit("\x1b[%d;%dH╗", pos_r, pos_c + width + 1);
+  emit("\x1b[%d;%dH╚", pos_r + rows + 1, pos_c);
+  emit("\x1b[%d;%dH╝", pos_r + rows + 1, pos_c + width + 1);
+}
 
-  printf("\x1b[%d;%dH╔", pos_r, pos_c);
-  printf("\x1b[%d;%dH╗", pos_r, pos_c + 2 * cols + 2);
-  printf("\x1b[%d;%dH╚", pos_r + rows + 1, pos_c);
-  printf("\x1b[%d;%dH╝", pos_r + rows + 1, pos_c + 2 * cols + 2);
+// The whole board scaled into the minimap box, with the part in view lit.
+static void printMinimap(const GameState& state, const BoardLayout& layout) {
+  int rows = layout.minimapRows;
+  int top = (term->viewTop - 1) * rows / state.rows;
+  int bottom = ((term->viewTop - 1 + layout.rows) * rows - 1) / state.rows;
+  int left = (term->viewLeft - 1) * MINIMAP_COLS / state.cols;
+  int right =
+      ((term->viewLeft - 1 + layout.cols) * MINIMAP_COLS - 1) / state.cols;
+  int* front = term->frontMinimap;
+  if (front[0] == top && front[1] == bottom && front[2] == left &&
+      front[3] == right)
+    return;
+  front[0] = top, front[1] = bottom, front[2] = left, front[3] = right;
+
+  int color = -1;
+  for (int r = 0; r < rows; r++) {
+    emit("\x1b[%d;%dH", layout.minimap_r + 1 + r, layout.minimap_c + 1);
+    for (int c = 0; c < MINIMAP_COLS; c++) {
+      bool inView = r >= top && r <= bottom && c >= left && c <= right;
+      if ((inView ? 97 : 90) != color)
+        emit("\x1b[%dm", color = inView ? 97 : 90);
+      emit(inView ? "█" : "░");
+    }
+  }
+  emit("\x1b[97m");
 }
 
+static void emitCell(unsigned char cell, int& color, int& reverse) {
+  const CellGlyph& glyph = glyphs[cell & 0x7f];
+  bool cellReverse = glyph.reverse || (cell & 0x80);
+  if (cellReverse != reverse && glyph.color != color)
+    emit("\x1b[%d;%dm", cellReverse ? 7 : 27, glyph.color);
+  else if (cellReverse != reverse)
+    emitBytes(cellReverse ? "\x1b[7m" : "\x1b[27m", cellReverse ? 4 : 5);
+  else if (glyph.color != color)
+    emit("\x1b[%dm", glyph.color);
+  reverse = cellReverse;
+  color = glyph.color;
+  emitBytes(glyph.glyph, strlen(glyph.glyph));
+}
+
+// Display codes of the board with unopened cells replaced by their hint.
+static void applyHints(const GameState& state, const Hints& hints) {
+  if (term->hintsVersion == hints.version)
+    return;
+  term->hintsVersion = hints.version;
+  std::vector<unsigned char>& hintCodes = term->hintCodes;
+  hintCodes.assign(state.cells.size(), 0);
+  for (int index = 0; index < (int)state.cells.size(); index++) {
+    float probability = hints.probability[index];
+    if (probability < 0)
+      continue;
+    hintCodes[index] = probability < 0.2f   ? HINT_LOW
+                       : probability < 0.5f ? HINT_MEDIUM
+                                            : HINT_HIGH;
+  }
+  for (const CellPos& cell : hints.safe)
+    hintCodes[cellIndex(state, cell.r, cell.c)] = HINT_SAFE;
+  for (const CellPos& cell : hints.mines)
+    hintCodes[cellIndex(state, cell.r, cell.c)] = HINT_MINE;
+}
+
+// Draws the part of the board in view; only cells that differ from what the
+// terminal shows are sent, so the cost follows the view, not the board.
 static void printBoard(const GameState& state,
-                       int pos_r,
-                       int pos_c,
+                       const BoardLayout& layout,
                        int cursor_r,
-                       int cursor_c) {
+                       int cursor_c,
+                       const Hints* hints) {
+  int pos_r = layout.pos_r, pos_c = layout.pos_c;
+  int rows = layout.rows, cols = layout.cols;
   int innerBoard_r = pos_r + 1;
   int innerBoard_c = pos_c + 2;
 
-  printBoardBorder(pos_r, pos_c, state.rows, state.cols);
-  for (int r = 1; r <= state.rows; r++) {
-    for (int c = 1; c <= state.cols; c++) {
-      if (r == cursor_r && c == cursor_c)
-        printf("\x1b[7m");
-      printf("\x1b[%d;%dH", innerBoard_r + r - 1, innerBoard_c + 2 * (c - 1));
-      printf("%s", cellToChar(state.display[r][c]));
-      if (r == cursor_r && c == cursor_c)
-        printf("\x1b[27m");
-      printf("\x1b[97m");
+  if (term->screenDirty || pos_r != term->front_r || pos_c != term->front_c ||
+      rows != term->frontRows || cols != term->frontCols) {
+    printBox(pos_r, pos_c, rows, 2 * cols + 1);
+    if (layout.minimapRows)
+      printBox(layout.minimap_r, layout.minimap_c, layout.minimapRows,
+               MINIMAP_COLS);
+    term->frontCells.assign((size_t)rows * (cols + 1), 0xff);
+    std::fill(term->frontMinimap, term->frontMinimap + 4, -1);
+    term->front_r = pos_r, term->front_c = pos_c;
+    term->frontRows = rows, term->frontCols = cols;
+    term->screenDirty = false;
+  }
+
+  scrollView(state, layout, cursor_r, cursor_c);
+  if (layout.minimapRows)
+    printMinimap(state, layout);
+
+  if (hints)
+    applyHints(state, *hints);
+  term->backCells.resize(cols + 1);
+  unsigned char* back = term->backCells.data();
+  int color = -1, reverse = -1;
+  for (int r = 1; r <= rows; r++) {
+    unsigned char* front = &term->frontCells[(size_t)(r - 1) * (cols + 1)];
+    int board_r = term->viewTop + r - 1;
+    for (int c = 1; c <= cols; c++) {
+      int board_c = term->viewLeft + c - 1;
+      int index = cellIndex(state, board_r, board_c);
+      unsigned char display = displayAt(state, board_r, board_c);
+      if (hints && display == 9 && term->hintCodes[index])
+        display = term->hintCodes[index];
+      back[c] = display |
+                (board_r == cursor_r && board_c == cursor_c ? 0x80 : 0);
+    }
+
+    for (int c = 1; c <= cols; c++) {
+      if (back[c] == front[c])
+        continue;
+
+      // Re-sending one unchanged cell is cheaper than another cursor move,
+      // so changed cells separated by a single clean cell share a run.
+      int end = c;
+      while (true) {
+        if (end + 1 <= cols && back[end + 1] != front[end + 1])
+          end += 1;
+        else if (end + 2 <= cols && back[end + 2] != front[end + 2])
+          end += 2;
+        else
+          break;
+      }
+
+      emit("\x1b[%d;%dH", innerBoard_r + r - 1, innerBoard_c + 2 * (c - 1));
+      for (int run = c; run <= end; run++) {
+        if (run > c) {
+          if (reverse == 1)
+            emitBytes("\x1b[27m", 5), reverse = 0;
+          emitBytes(" ", 1);
+        }
+        emitCell(back[run], color, reverse);
+        front[run] = back[run];
+      }
+      c = end;
     }
   }
+
+  if (reverse == 1 || (color != -1 && color != 97))
+    emitBytes("\x1b[27;97m", 8);
 }
 
 static void renderHeader(char fmt[], char header[], int pos_r, int pos_c) {
-  printf("\x1b[%d;%dH", pos_r, pos_c);
-  printf("\x1b[2K");
-  printf(fmt, header);
+  term->frontHeader[0] = '\0';
+  emit("\x1b[%d;%dH", pos_r, pos_c);
+  emit("\x1b[2K");
+  emit(fmt, header);
 }
 
 void render(const GameState& state,
@@ -307,101 +998,116 @@ void render(const GameState& state,
             int cursor_c,
             bool skipHeader,
             bool skipBoard,
-            bool skipFooter) {
-  int boardWidth = 2 * state.cols - 1 + 4;
-  int boardHeight = state.rows + 2;
+            bool skipFooter,
+            const Hints* hints) {
+  uint64_t start = metricsClock();
   int consoleWidth, consoleHeight;
   getConsoleWidthHeight(consoleWidth, consoleHeight);
-  int board_r = (consoleHeight - boardHeight - 3) / 2 + 3;
-  int board_c = (consoleWidth - boardWidth) / 2 + 1;
-  if (consoleWidth != lastWidth || consoleHeight != lastHeight)
+  if (consoleWidth != term->lastWidth || consoleHeight != term->lastHeight)
     clearScreenInline(40);
 
-  lastWidth = consoleWidth;
-  lastHeight = consoleHeight;
+  term->lastWidth = consoleWidth;
+  term->lastHeight = consoleHeight;
 
-  assertScreenSize(boardHeight + 3, std::max(boardWidth, 63));
+  // Boards larger than the terminal scroll, so it only needs a few rows.
+  assertScreenSize(std::min(state.rows, 3) + 5, 72);
+  getConsoleWidthHeight(consoleWidth, consoleHeight);
+  BoardLayout layout;
+  layoutBoard(state, layout);
+  bool fullRedraw = term->screenDirty;
 
   // HEADER
   if (!skipHeader) {
-    int flagCount = 0;
-    for (int r = 1; r <= state.rows; r++)
-      for (int c = 1; c <= state.cols; c++)
-        if (state.display[r][c] == 10)
-          flagCount++;
     char header[100];
     sprintf(header, "Time: %3ds   |   Mines: %2d/%d", state.elapsedTime,
-            flagCount, state.bombCount);
-    renderHeader((char*)"%s", header, 1,
-                 (consoleWidth - strlen(header)) / 2 + 1);
+            state.flagCount, state.bombCount);
+    if (fullRedraw || strcmp(header, term->frontHeader) != 0) {
+      renderHeader((char*)"%s", header, 1,
+                   (consoleWidth - strlen(header)) / 2 + 1);
+      strcpy(term->frontHeader, header);
+    }
   }
 
   // FOOTER
-  if (!skipFooter) {
-    printf("\x1b[%d;1H", consoleHeight);
-    printf(
+  if (!skipFooter && fullRedraw) {
+    emit("\x1b[%d;1H", consoleHeight);
+    emit(
         "\x1b[34m[ESC]\x1b[97m Pause   \x1b[34m[SPACE]\x1b[97m Open cell   "
-        "\x1b[34m[F]\x1b[97m Flag cell   \x1b[34m[ARROWS]\x1b[97m Move");
+        "\x1b[34m[F]\x1b[97m Flag cell   \x1b[34m[H]\x1b[97m Hints   "
+        "\x1b[34m[ARROWS]\x1b[97m Move");
+  }
+
+  if (METRICS_ENABLED && term->showMetrics) {
+    char line[200];
+    formatMetricsOverlay(line, sizeof(line));
+    emit("\x1b[2;1H\x1b[2K\x1b[90m%.*s\x1b[97m", consoleWidth, line);
   }
 
   if (!skipBoard)
-    printBoard(state, board_r, board_c, cursor_r, cursor_c);
-  fflush(stdout);
+    printBoard(state, layout, cursor_r, cursor_c, hints);
+  size_t bytes = term->outSize;
+  flushOutput();
+  recordElapsed(METRIC_RENDER_TIME, start);
+  recordMetric(METRIC_RENDER_BYTES, bytes);
+}
+
+void toggleMetricsOverlay() {
+  if (!METRICS_ENABLED)
+    return;
+  term->showMetrics = !term->showMetrics;
+  clearScreenInline(40);
 }
 
 static void renderPauseMenu(const GameState& state) {
-  int boardWidth = 2 * state.cols - 1 + 4;
-  int boardHeight = state.rows + 2;
   int consoleWidth, consoleHeight;
   getConsoleWidthHeight(consoleWidth, consoleHeight);
-  int board_r = (consoleHeight - boardHeight - 3) / 2 + 3;
-  int board_c = (consoleWidth - boardWidth) / 2 + 1;
-
-  lastWidth = consoleWidth;
-  lastHeight = consoleHeight;
+  term->lastWidth = consoleWidth;
+  term->lastHeight = consoleHeight;
 
-  assertScreenSize(boardHeight + 3, std::max(boardWidth, 41));
+  assertScreenSize(std::min(state.rows, 3) + 5, 41);
+  getConsoleWidthHeight(consoleWidth, consoleHeight);
+  BoardLayout layout;
+  layoutBoard(state, layout);
+  int boardWidth = 2 * layout.cols - 1 + 4;
 
   // HEADER
-  int flagCount = 0;
-  for (int r = 1; r <= state.rows; r++)
-    for (int c = 1; c <= state.cols; c++)
-      if (state.display[r][c] == 10)
-        flagCount++;
   char header[100];
   sprintf(header, "Time: %3ds   |   Mines: %2d/%d", state.elapsedTime,
-          flagCount, state.bombCount);
+          state.flagCount, state.bombCount);
   renderHeader((char*)"%s", header, 1, (consoleWidth - strlen(header)) / 2 + 1);
 
   // FOOTER
-  printf("\x1b[%d;1H", consoleHeight);
-  printf("\x1b[2K");
-  printf(
+  emit("\x1b[%d;1H", consoleHeight);
+  emit("\x1b[2K");
+  emit(
       "\x1b[34m[ESC]\x1b[97m Continue   \x1b[34m[S]\x1b[97m Save game   "
       "\x1b[34m[Q]\x1b[97m Quit");
 
-  printBoardBorder(board_r, board_c, state.rows, state.cols);
+  printBox(layout.pos_r, layout.pos_c, layout.rows, 2 * layout.cols + 1);
 
-  for (int r = board_r + 1; r <= board_r + state.rows; r++)
-    for (int c = board_c + 1; c <= board_c + 2 * state.cols + 1; c++)
-      printf("\x1b[%d;%dH ", r, c);
+  for (int r = layout.pos_r + 1; r <= layout.pos_r + layout.rows; r++)
+    emit("\x1b[%d;%dH\x1b[%dX", r, layout.pos_c + 1, 2 * layout.cols + 1);
 
-  printf("\x1b[%d;%dH%s", board_r + (state.rows - 1) / 2 + 1,
-         board_c + (boardWidth - 2 - 8) / 2 + 1, "⏳PAUSED⏳");
-  fflush(stdout);
+  emit("\x1b[%d;%dH%s", layout.pos_r + (layout.rows - 1) / 2 + 1,
+         layout.pos_c + (boardWidth - 2 - 8) / 2 + 1, "⏳PAUSED⏳");
+  flushOutput();
 }
 
 int pauseMenu(const GameState& state) {
   renderPauseMenu(state);
   while (true) {
+    int events = waitForEvents(EVENT_INPUT | EVENT_RESIZE);
     int consoleWidth, consoleHeight;
     getConsoleWidthHeight(consoleWidth, consoleHeight);
-    if (consoleWidth != lastWidth || consoleHeight != lastHeight) {
+    if (consoleWidth != term->lastWidth || consoleHeight != term->lastHeight) {
       clearScreenInline(40);
       renderPauseMenu(state);
     }
-    lastWidth = consoleWidth;
-    lastHeight = consoleHeight;
+    term->lastWidth = consoleWidth;
+    term->lastHeight = consoleHeight;
+
+    if (!(events & EVENT_INPUT))
+      continue;
 
     int keyCode = getInput();
     if (keyCode == 'q')
@@ -421,31 +1127,31 @@ int mainMenu(bool saved) {
   while (true) {
     int width, height;
     getConsoleWidthHeight(width, height);
-    if (width != lastWidth || height != lastHeight)
+    if (width != term->lastWidth || height != term->lastHeight)
       clearScreenInline(40);
-    lastWidth = width;
-    lastHeight = height;
+    term->lastWidth = width;
+    term->lastHeight = height;
     int menuHeight = 2 + 4 + 3 * numberOfOptions + 1;
     int menuWidth = 36;
     int menu_r = (height - menuHeight) / 2 + 1;
     int menu_c = (width - menuWidth) / 2 + 1;
     assertScreenSize(menuHeight, menuWidth);
 
-    printf("\x1b[%d;%dH", menu_r, menu_c + 1);
+    emit("\x1b[%d;%dH", menu_r, menu_c + 1);
     for (int i = 1; i < menuWidth - 1; i++)
-      printf("═");
-    printf("\x1b[%d;%dH", menu_r + menuHeight - 1, menu_c + 1);
+      emit("═");
+    emit("\x1b[%d;%dH", menu_r + menuHeight - 1, menu_c + 1);
     for (int i = 1; i < menuWidth - 1; i++)
-      printf("═");
+      emit("═");
     for (int i = menu_r + 1; i < menu_r + menuHeight - 1; i++)
-      printf("\x1b[%d;%dH║", i, menu_c);
+      emit("\x1b[%d;%dH║", i, menu_c);
     for (int i = menu_r + 1; i < menu_r + menuHeight - 1; i++)
-      printf("\x1b[%d;%dH║", i, menu_c + menuWidth - 1);
+      emit("\x1b[%d;%dH║", i, menu_c + menuWidth - 1);
 
-    printf("\x1b[%d;%dH╔", menu_r, menu_c);
-    printf("\x1b[%d;%dH╗", menu_r, menu_c + menuWidth - 1);
-    printf("\x1b[%d;%dH╚", menu_r + menuHeight - 1, menu_c);
-    printf("\x1b[%d;%dH╝", menu_r + menuHeight - 1, menu_c + menuWidth - 1);
+    emit("\x1b[%d;%dH╔", menu_r, menu_c);
+    emit("\x1b[%d;%dH╗", menu_r, menu_c + menuWidth - 1);
+    emit("\x1b[%d;%dH╚", menu_r + menuHeight - 1, menu_c);
+    emit("\x1b[%d;%dH╝", menu_r + menuHeight - 1, menu_c + menuWidth - 1);
 
     int newGame_r = menu_r + 2 + 4;
     int newGame_c = menu_c + (menuWidth - 10) / 2;
@@ -454,16 +1160,19 @@ int mainMenu(bool saved) {
     int quitGame_r = menu_r + 2 + 4 + (numberOfOptions - 1) * 3;
     int quitGame_c = menu_c + (menuWidth - 6) / 2;
 
-    printf("\x1b[%d;%dH\x1b[91m%s\x1b[97m", menu_r + 2,
+    emit("\x1b[%d;%dH\x1b[91m%s\x1b[97m", menu_r + 2,
            menu_c + (menuWidth - 16) / 2, "🚩 MINESWEEPER 🚩");
-    printf("\x1b[%d;%dH\x1b[%dm%s\x1b[27m", newGame_r, newGame_c,
+    emit("\x1b[%d;%dH\x1b[%dm%s\x1b[27m", newGame_r, newGame_c,
            select == 1 ? 7 : 27, "[NEW GAME]");
     if (saved)
-      printf("\x1b[%d;%dH\x1b[%dm%s\x1b[27m", resumeGame_r, resumeGame_c,
+      emit("\x1b[%d;%dH\x1b[%dm%s\x1b[27m", resumeGame_r, resumeGame_c,
              select == 2 ? 7 : 27, "[RESUME GAME]");
-    printf("\x1b[%d;%dH\x1b[%dm%s\x1b[27m", quitGame_r, quitGame_c,
+    emit("\x1b[%d;%dH\x1b[%dm%s\x1b[27m", quitGame_r, quitGame_c,
            select + !saved == 3 ? 7 : 27, "[QUIT]");
-    fflush(stdout);
+    flushOutput();
+
+    if (!(waitForEvents(EVENT_INPUT | EVENT_RESIZE) & EVENT_INPUT))
+      continue;
 
     int keyCode = getInput();
     int mouse_r, mouse_c, mouse_event;
@@ -506,92 +1215,122 @@ int mainMenu(bool saved) {
   }
 }
 
-int lastRows = 16, lastCols = 30, lastBombCount = 99;
+// "<  value  >" for a start menu option, centred in a fixed width.
+static void formatOption(char* out, const char* value) {
+  int pad = 7 - (int)strlen(value);
+  sprintf(out, "< %*s%s%*s >", (pad + 1) / 2, "", value, pad / 2, "");
+}
 
-void startGameMenu(int& rows, int& cols, int& bombCount) {
+void startGameMenu(int& rows, int& cols, int& bombCount, bool& noGuess) {
   clearScreenInline(40);
   int select = 1;
-  rows = lastRows, cols = lastCols, bombCount = lastBombCount;
+  // Larger boards than the terminal scroll; the save format caps the cell
+  // count at 4096 x 4096, and server sessions are capped lower.
+  const int MIN_ROWS = 3;
+  const int MIN_COLS = 5;
+  const int MAX_ROWS = term->maxRows;
+  const int MAX_COLS = term->maxCols;
+  const int MIN_BOMB = 1;
+  auto clampOptions = [&] {
+    rows = std::max(MIN_ROWS, std::min(MAX_ROWS, rows));
+    cols = std::max(MIN_COLS, std::min(MAX_COLS, cols));
+    bombCount = std::max(MIN_BOMB, std::min(rows * cols / 2, bombCount));
+  };
+  // Digits typed into a numeric option replace its value; the limits apply
+  // once the entry is finished.
+  bool typing = false;
+  rows = term->lastRows, cols = term->lastCols;
+  bombCount = term->lastBombCount;
+  noGuess = term->lastNoGuess;
   while (true) {
     int width, height;
     getConsoleWidthHeight(width, height);
-    if (width != lastWidth || height != lastHeight)
+    if (width != term->lastWidth || height != term->lastHeight)
       clearScreenInline(40);
-    lastWidth = width;
-    lastHeight = height;
-    int menuHeight = 2 + 2 * 3 + 1;
+    term->lastWidth = width;
+    term->lastHeight = height;
+    int menuHeight = 2 + 2 * 4 + 1;
     int menuWidth = 36;
     int menu_r = (height - menuHeight - 1) / 2 + 1;
     int menu_c = (width - menuWidth) / 2 + 1;
 
     assertScreenSize(menuHeight + 1, std::max(menuWidth, 70));
 
-    printf("\x1b[%d;%dH", menu_r, menu_c + 1);
+    emit("\x1b[%d;%dH", menu_r, menu_c + 1);
     for (int i = 1; i < menuWidth - 1; i++)
-      printf("═");
-    printf("\x1b[%d;%dH", menu_r + menuHeight - 1, menu_c + 1);
+      emit("═");
+    emit("\x1b[%d;%dH", menu_r + menuHeight - 1, menu_c + 1);
     for (int i = 1; i < menuWidth - 1; i++)
-      printf("═");
+      emit("═");
     for (int i = menu_r + 1; i < menu_r + menuHeight - 1; i++)
-      printf("\x1b[%d;%dH║", i, menu_c);
+      emit("\x1b[%d;%dH║", i, menu_c);
     for (int i = menu_r + 1; i < menu_r + menuHeight - 1; i++)
-      printf("\x1b[%d;%dH║", i, menu_c + menuWidth - 1);
-
-    printf("\x1b[%d;%dH╔", menu_r, menu_c);
-    printf("\x1b[%d;%dH╗", menu_r, menu_c + menuWidth - 1);
-    printf("\x1b[%d;%dH╚", menu_r + menuHeight - 1, menu_c);
-    printf("\x1b[%d;%dH╝", menu_r + menuHeight - 1, menu_c + menuWidth - 1);
-
-    int MIN_ROWS = 3;
-    int MIN_COLS = 5;
-    int MAX_ROWS = 40;
-    int MAX_COLS = 40;
-    int MIN_BOMB = 1;
-    int MAX_BOMB = rows * cols / 2;
-
-    if (bombCount > MAX_BOMB)
-      bombCount = MAX_BOMB;
-
-    char str_rows[100], str_cols[100], str_bomb[100];
-    sprintf(str_rows, "Minefield Height: \x1b[%dm<  %2d  >\x1b[27m",
-            select == 1 ? 7 : 27, rows);
-    sprintf(str_cols, "Minefield Width:  \x1b[%dm<  %2d  >\x1b[27m",
-            select == 2 ? 7 : 27, cols);
-    sprintf(str_bomb, "Number of Mines:  \x1b[%dm< %*s%2d%*s >\x1b[27m",
-            select == 3 ? 7 : 27, bombCount > 99 ? 0 : 1, "", bombCount,
-            bombCount > 999 ? 0 : 1, "");
+      emit("\x1b[%d;%dH║", i, menu_c + menuWidth - 1);
+
+    emit("\x1b[%d;%dH╔", menu_r, menu_c);
+    emit("\x1b[%d;%dH╗", menu_r, menu_c + menuWidth - 1);
+    emit("\x1b[%d;%dH╚", menu_r + menuHeight - 1, menu_c);
+    emit("\x1b[%d;%dH╝", menu_r + menuHeight - 1, menu_c + menuWidth - 1);
+
+    if (!typing)
+      clampOptions();
+
+    char value[4][16], option[4][32];
+    sprintf(value[0], "%d", rows);
+    sprintf(value[1], "%d", cols);
+    sprintf(value[2], "%d", bombCount);
+    sprintf(value[3], "%s", noGuess ? "ON" : "OFF");
+    for (int i = 0; i < 4; i++)
+      formatOption(option[i], value[i]);
+    char str_rows[100], str_cols[100], str_bomb[100], str_guess[100];
+    sprintf(str_rows, "Minefield Height: \x1b[%dm%s\x1b[27m",
+            select == 1 ? 7 : 27, option[0]);
+    sprintf(str_cols, "Minefield Width:  \x1b[%dm%s\x1b[27m",
+            select == 2 ? 7 : 27, option[1]);
+    sprintf(str_bomb, "Number of Mines:  \x1b[%dm%s\x1b[27m",
+            select == 3 ? 7 : 27, option[2]);
+    sprintf(str_guess, "No Guessing:      \x1b[%dm%s\x1b[27m",
+            select == 4 ? 7 : 27, option[3]);
 
     int height_r = menu_r + 2;
     int width_r = menu_r + 2 + 2;
     int bomb_r = menu_r + 2 + 2 + 2;
+    int guess_r = menu_r + 2 + 2 + 2 + 2;
     int options_c = menu_c + 4;
-    printf("\x1b[%d;%dH%s", height_r, options_c, str_rows);
-    printf("\x1b[%d;%dH%s", width_r, options_c, str_cols);
-    printf("\x1b[%d;%dH%s", bomb_r, options_c, str_bomb);
+    emit("\x1b[%d;%dH%s", height_r, options_c, str_rows);
+    emit("\x1b[%d;%dH%s", width_r, options_c, str_cols);
+    emit("\x1b[%d;%dH%s", bomb_r, options_c, str_bomb);
+    emit("\x1b[%d;%dH%s", guess_r, options_c, str_guess);
 
     // FOOTER
-    printf("\x1b[%d;1H", height);
-    printf(
+    emit("\x1b[%d;1H", height);
+    emit(
         "\x1b[34m[UP/DOWN]\x1b[97m Choose options   "
         "\x1b[34m[LEFT/RIGHT]\x1b[97m Change value   \x1b[34m[ENTER]\x1b[97m "
         "Confirm");
-    fflush(stdout);
+    flushOutput();
+
+    if (!(waitForEvents(EVENT_INPUT | EVENT_RESIZE) & EVENT_INPUT))
+      continue;
 
     int keyCode = getInput();
     int mouse_r, mouse_c, mouse_event;
     if (getMouseInput(mouse_r, mouse_c, mouse_event)) {
       if (mouse_event == 0) {
         if (mouse_r == height_r && mouse_c >= options_c &&
-            mouse_c < options_c + 26)
+            mouse_c < options_c + 29)
           select = 1;
         else if (mouse_r == width_r && mouse_c >= options_c &&
-                 mouse_c < options_c + 26)
+                 mouse_c < options_c + 29)
           select = 2;
         else if (mouse_r == bomb_r && mouse_c >= options_c &&
-                 mouse_c < options_c + 26)
+                 mouse_c < options_c + 29)
           select = 3;
+        else if (mouse_r == guess_r && mouse_c >= options_c &&
+                 mouse_c < options_c + 29)
+          select = 4;
       } else if (mouse_event == 1 &&
-                 (mouse_c == options_c + 18 || mouse_c == options_c + 25)) {
+                 (mouse_c == options_c + 18 || mouse_c == options_c + 28)) {
         if (mouse_r == height_r)
           select = 1,
           keyCode = mouse_c == options_c + 18 ? KEY_LEFT_ARROW : KEY_RIGHT_ARROW;
@@ -601,10 +1340,32 @@ void startGameMenu(int& rows, int& cols, int& bombCount) {
         else if (mouse_r == bomb_r)
           select = 3,
           keyCode = mouse_c == options_c + 18 ? KEY_LEFT_ARROW : KEY_RIGHT_ARROW;
+        else if (mouse_r == guess_r)
+          select = 4,
+          keyCode = mouse_c == options_c + 18 ? KEY_LEFT_ARROW : KEY_RIGHT_ARROW;
       }
     }
+    bool digit = keyCode >= '0' && keyCode <= '9';
+    if (select <= 3 && (digit || keyCode == 8 || keyCode == 127)) {
+      int& option = select == 1 ? rows : select == 2 ? cols : bombCount;
+      int limit = select == 1 ? MAX_ROWS
+                  : select == 2 ? MAX_COLS
+                                : std::max(MIN_BOMB, rows * cols / 2);
+      if (digit)
+        option = std::min(limit, (typing ? option * 10 : 0) + keyCode - '0');
+      else
+        option /= 10;
+      typing = true;
+      continue;
+    }
+    if (typing) {
+      typing = false;
+      clampOptions();
+    }
+    int MAX_BOMB = rows * cols / 2;
+
     if (keyCode == KEY_DOWN_ARROW)
-      select = std::min(3, select + 1);
+      select = std::min(4, select + 1);
     else if (keyCode == KEY_UP_ARROW)
       select = std::max(1, select - 1);
     else if (keyCode == KEY_LEFT_ARROW) {
@@ -612,17 +1373,23 @@ void startGameMenu(int& rows, int& cols, int& bombCount) {
         rows = std::max(MIN_ROWS, rows - 1);
       else if (select == 2)
         cols = std::max(MIN_COLS, cols - 1);
-      else
+      else if (select == 3)
         bombCount = std::max(MIN_BOMB, bombCount - 1);
+      else
+        noGuess = !noGuess;
     } else if (keyCode == KEY_RIGHT_ARROW) {
       if (select == 1)
         rows = std::min(MAX_ROWS, rows + 1);
       else if (select == 2)
         cols = std::min(MAX_COLS, cols + 1);
-      else
+      else if (select == 3)
         bombCount = std::min(MAX_BOMB, bombCount + 1);
+      else
+        noGuess = !noGuess;
     } else if (keyCode == '\r' || keyCode == '\n') {
-      lastRows = rows, lastCols = cols, lastBombCount = bombCount;
+      term->lastRows = rows, term->lastCols = cols;
+      term->lastBombCount = bombCount;
+      term->lastNoGuess = noGuess;
       return;
     }
   }
@@ -639,20 +1406,24 @@ static void renderLoseMenu(const GameState& state, int cursor_r, int cursor_c) {
                (consoleWidth - strlen(msg)) / 2 + 1);
 
   // FOOTER
-  printf("\x1b[%d;1H", consoleHeight);
-  printf("\x1b[2K");
-  printf("\x1b[34m[ESC]\x1b[97m Back to Menu   \x1b[34m[Q]\x1b[97m Quit");
-  fflush(stdout);
+  emit("\x1b[%d;1H", consoleHeight);
+  emit("\x1b[2K");
+  emit("\x1b[34m[ESC]\x1b[97m Back to Menu   \x1b[34m[Q]\x1b[97m Quit");
+  flushOutput();
 }
 
 bool loseMenu(const GameState& state, int cursor_r, int cursor_c) {
   renderLoseMenu(state, cursor_r, cursor_c);
   while (true) {
+    int events = waitForEvents(EVENT_INPUT | EVENT_RESIZE);
     int consoleWidth, consoleHeight;
     getConsoleWidthHeight(consoleWidth, consoleHeight);
-    if (consoleWidth != lastWidth || consoleHeight != lastHeight)
+    if (consoleWidth != term->lastWidth || consoleHeight != term->lastHeight)
       renderLoseMenu(state, cursor_r, cursor_c);
 
+    if (!(events & EVENT_INPUT))
+      continue;
+
     int keyCode = getInput();
     if (keyCode == 'q')
       return false;
@@ -667,29 +1438,36 @@ static void renderWinMenu(const GameState& state, int bestTime) {
   render(state, 0, 0, true, false, true);
 
   // HEADER
+  // 3BV/s counts the game's first second even when it took less.
+  BoardStats stats = analyzeBoard(state);
   char header[100];
-  sprintf(header, "Time: %3ds   |   Best Time: %3ds", state.elapsedTime,
-          bestTime);
+  sprintf(header, "Time: %3ds   |   Best Time: %3ds   |   3BV: %d (%.2f/s)",
+          state.elapsedTime, bestTime, stats.bbbv,
+          (double)stats.bbbv / std::max(1, state.elapsedTime));
   renderHeader((char*)"%s", header, 1, (consoleWidth - strlen(header)) / 2 + 1);
   char msg[] = "YOU WIN!";
   renderHeader((char*)"\x1b[42m%s\x1b[40m", msg, 2,
                (consoleWidth - strlen(msg)) / 2 + 1);
 
   // FOOTER
-  printf("\x1b[%d;1H", consoleHeight);
-  printf("\x1b[2K");
-  printf("\x1b[34m[ESC]\x1b[97m Back to Menu   \x1b[34m[Q]\x1b[97m Quit");
-  fflush(stdout);
+  emit("\x1b[%d;1H", consoleHeight);
+  emit("\x1b[2K");
+  emit("\x1b[34m[ESC]\x1b[97m Back to Menu   \x1b[34m[Q]\x1b[97m Quit");
+  flushOutput();
 }
 
 bool winMenu(const GameState& state, int bestTime) {
   renderWinMenu(state, bestTime);
   while (true) {
+    int events = waitForEvents(EVENT_INPUT | EVENT_RESIZE);
     int consoleWidth, consoleHeight;
     getConsoleWidthHeight(consoleWidth, consoleHeight);
-    if (consoleWidth != lastWidth || consoleHeight != lastHeight)
+    if (consoleWidth != term->lastWidth || consoleHeight != term->lastHeight)
       renderWinMenu(state, bestTime);
 
+    if (!(events & EVENT_INPUT))
+      continue;
+
     int keyCode = getInput();
     if (keyCode == 'q')
       return false;
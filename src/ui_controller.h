@@ -1,6 +1,11 @@
 #ifndef UI_CONTROLLER_H
 #define UI_CONTROLLER_H
+#include <stddef.h>
+#include <chrono>
+#include <functional>
+#include <vector>
 #include "game_controller.h"
+#include "solver.h"
 
 #ifdef __WIN32
 
@@ -20,6 +25,98 @@
 
 #endif
 
+#define EVENT_INPUT 1
+#define EVENT_RESIZE 2
+#define EVENT_TIMER 4
+// The frame interval has passed and the output is not backed up.
+#define EVENT_FRAME 8
+
+#define DEFAULT_FPS 60
+
+// A decoded key or mouse report. Keys are lower-cased characters or KEY_*
+// codes, with mouse -1; mouse reports are 0 (move), 1 (left press) or 2 (right
+// press) at screen row r, column c, with key -1.
+struct InputEvent {
+  int key, mouse;
+  int r, c;
+};
+
+// Thrown by waitForEvents() once the console's input has ended (end of file,
+// hangup), to unwind the game as a closed server session is.
+struct InputClosed {};
+
+// Sizes of the per-terminal rings of undecoded bytes and decoded events.
+const size_t INPUT_BYTES = 1024, INPUT_EVENTS = 128;
+
+// Everything the UI keeps about one terminal: its size, clock tick, output
+// buffer, what the screen currently shows and the last menu choices. The
+// functions below draw to and read from the current terminal, which is the
+// process's console unless setTerminal() selected another one.
+struct Terminal {
+  // Set for a server session, whose hooks replace stdin/stdout, SIGWINCH and
+  // the timer. readInput returns up to `size` buffered input bytes.
+  void* session = nullptr;
+  int (*waitEvents)(void* session, int mask) = nullptr;
+  int (*readInput)(void* session, char* buffer, int size) = nullptr;
+  void (*writeOutput)(void* session, const char* bytes, size_t size) = nullptr;
+  // True while earlier frames are still queued for the client.
+  bool (*outputBusy)(void* session) = nullptr;
+  // Runs `work` off the thread that serves the session and returns once it
+  // has finished.
+  void (*runWork)(void* session, const std::function<void()>& work) = nullptr;
+  // Largest board the start menu offers.
+  int maxRows = 4096, maxCols = 4096;
+
+  int width = -1, height = -1;
+  std::chrono::steady_clock::time_point nextTick;
+  // Earliest time the next frame may be sent.
+  std::chrono::steady_clock::time_point nextFrame;
+  std::vector<char> out;
+  size_t outSize = 0;
+  int lastWidth = -1, lastHeight = -1;
+  // What the terminal currently shows for the board, so that a frame only
+  // carries the cells that changed since the previous one.
+  std::vector<unsigned char> frontCells, backCells;
+  int front_r = -1, front_c = -1, frontRows = -1, frontCols = -1;
+  int frontMinimap[4] = {-1, -1, -1, -1};
+  bool screenDirty = true;
+  // First board row and column shown when the board does not fit.
+  int viewTop = 1, viewLeft = 1;
+  // Hint overlay codes by cellIndex(), rebuilt when Hints::version changes.
+  std::vector<unsigned char> hintCodes;
+  uint64_t hintsVersion = 0;
+  char frontHeader[100] = "";
+  // Input read but not yet decoded, and decoded events not yet consumed, as
+  // rings indexed by free-running counters. mouseEvent holds the mouse report
+  // that getInput() took off the queue for getMouseInput().
+  unsigned char inputBytes[INPUT_BYTES];
+  size_t inputHead = 0, inputTail = 0;
+  InputEvent inputEvents[INPUT_EVENTS];
+  size_t eventHead = 0, eventTail = 0;
+  InputEvent mouseEvent = {-1, -1, 0, 0};
+  // When the oldest input not yet answered by a flush arrived (metricsClock).
+  uint64_t inputTime = 0;
+  bool showMetrics = false;
+  int lastRows = 16, lastCols = 30, lastBombCount = 99;
+  bool lastNoGuess = false;
+};
+
+// Makes `terminal` (the console if null) current; returns the previous one.
+Terminal* setTerminal(Terminal* terminal);
+
+// Caps how often frames are sent to each terminal; 0 removes the cap.
+void setFrameRate(int fps);
+// Whether a frame may be sent now: the frame interval has passed since the
+// last flush and the terminal has taken the previous frames. Loops that redraw
+// on every event should render only when this holds, and otherwise wait for
+// EVENT_FRAME, so a burst of input turns into one frame and a slow client
+// skips frames instead of queueing them.
+bool frameReady();
+// Runs work that can take a while, such as generating a board or its hints.
+// A server session hands it to a worker thread and waits, so the other
+// sessions keep being served; the console runs it in place.
+void runWork(const std::function<void()>& work);
+
 void initConsole();
 void closeConsole();
 void hideCursor();
@@ -32,16 +129,30 @@ bool screenToBoard(GameState& state,
                    int screen_c,
                    int& board_r,
                    int& board_c);
+// Shows or hides the latency overlay above the board; a no-op unless metrics
+// are compiled in.
+void toggleMetricsOverlay();
 void render(const GameState& state,
             int cursor_r,
             int cursor_c,
             bool skipHeader = false,
             bool skipBoard = false,
-            bool skipFooter = false);
+            bool skipFooter = false,
+            const Hints* hints = nullptr);
+int waitForEvents(int mask);
+void resetTimer();
+// Each getInput() takes one event off the input queue: a key is returned, a
+// mouse report is left for getMouseInput() and -1 returned.
 int getInput();
 bool getMouseInput(int& r, int& c, int& event);
+// Whether decoded input is still queued; a loop can handle all of it before
+// drawing, so a burst of cursor moves costs one frame.
+bool inputPending();
+// Asks the terminal for SGR (1006) mouse reports; initConsole() enables them
+// for the console. The Windows console reports the mouse natively.
+void setMouseReporting(bool enabled);
 int mainMenu(bool saved);
-void startGameMenu(int& rows, int& cols, int& bombCount);
+void startGameMenu(int& rows, int& cols, int& bombCount, bool& noGuess);
 bool loseMenu(const GameState& state, int cursor_r, int cursor_c);
 bool winMenu(const GameState& state, int bestTime);
 int pauseMenu(const GameState& state);
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <string.h>
+#include "../src/analysis.h"
+#include "../src/bitboard.h"
+
+// Checks the board statistics on hand-made boards.
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  if (!ok) {
+    fprintf(stderr, "FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+// One string per row, '*' for a mine.
+static void makeBoard(GameState& state, const char* const* rows, int count) {
+  int cols = strlen(rows[0]), mines = 0;
+  for (int r = 0; r < count; r++)
+    for (int c = 0; c < cols; c++)
+      mines += rows[r][c] == '*';
+  initBoard(state, count, cols, mines);
+  MineBitboard bits;
+  initBitboard(bits, count, cols);
+  for (int r = 0; r < count; r++)
+    for (int c = 0; c < cols; c++)
+      if (rows[r][c] == '*')
+        setMineBit(bits, r + 1, c + 1);
+  applyBitboard(bits, state);
+  state.generated = true;
+}
+
+int main() {
+  // The safe corners of the top row are walled in by mines, so no opened
+  // number ever touches them. Opened from the bottom left, one guess next to
+  // the numbers clears the rest; guessing a corner first gains nothing.
+  const char* walled[] = {".*...*", "**..**", "......", "*.....", "......"};
+  GameState state;
+  makeBoard(state, walled, 5);
+  check(guessesNeeded(state, 5, 1) == 1, "guesses prefer the frontier");
+
+  const char* open[] = {"......", "......", "......", ".....*"};
+  makeBoard(state, open, 4);
+  check(guessesNeeded(state, 1, 1) == 0, "no guesses on an open board");
+  BoardStats stats = analyzeBoard(state);
+  check(stats.openings == 1 && stats.isolated == 0 && stats.bbbv == 1,
+        "one opening clears the board");
+
+  if (failures)
+    return 1;
+  printf("analysis: all checks passed\n");
+  return 0;
+}
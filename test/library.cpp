@@ -0,0 +1,96 @@
+#include <stdio.h>
+#include <vector>
+#include "../src/engine.h"
+#include "../src/savefile.h"
+
+// Linked against build/libminesweeper.so, so it only builds if everything the
+// public headers call is exported. Checks that every size Board::validSize()
+// accepts survives a save and a load, through both the C++ API and the C ABI.
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  if (!ok) {
+    fprintf(stderr, "FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static bool sameBoard(const Board& a, const Board& b) {
+  if (a.rows() != b.rows() || a.cols() != b.cols() || a.mines() != b.mines() ||
+      a.openedCount() != b.openedCount() || a.seed() != b.seed())
+    return false;
+  for (int r = 1; r <= a.rows(); r++)
+    for (int c = 1; c <= a.cols(); c++)
+      if (a.display(r, c) != b.display(r, c) || a.isMine(r, c) != b.isMine(r, c))
+        return false;
+  return true;
+}
+
+// Saves and loads the game before and after its first click.
+static void roundTrip(int rows, int cols, int mines, const char* name) {
+  char what[96];
+  snprintf(what, sizeof what, "%s: %dx%d, %d mines is valid", name, rows, cols,
+           mines);
+  check(Board::validSize(rows, cols, mines), what);
+
+  Game game(rows, cols, mines);
+  game.setSeed(42);
+  std::vector<unsigned char> data;
+  for (int move = 0; move < 2; move++) {
+    if (move)
+      game.open((rows + 1) / 2, (cols + 1) / 2);
+    game.save(data);
+    Game loaded(1, 1, 1);
+    snprintf(what, sizeof what, "%s: load after %d moves", name, move);
+    check(loaded.load(data.data(), data.size()), what);
+    snprintf(what, sizeof what, "%s: same board after %d moves", name, move);
+    check(sameBoard(game.board(), loaded.board()) &&
+              game.status() == loaded.status(),
+          what);
+  }
+
+  ms_game* c = ms_game_new(rows, cols, mines, 0);
+  snprintf(what, sizeof what, "%s: ms_game_new", name);
+  check(c != nullptr, what);
+  if (!c)
+    return;
+  ms_game_set_seed(c, 42);
+  ms_game_open(c, (rows + 1) / 2, (cols + 1) / 2);
+  std::vector<unsigned char> buffer(ms_game_save(c, nullptr, 0));
+  ms_game_save(c, buffer.data(), buffer.size());
+  ms_game* loaded = ms_game_load(buffer.data(), buffer.size());
+  snprintf(what, sizeof what, "%s: ms_game_load", name);
+  check(loaded && ms_game_opened(loaded) == ms_game_opened(c) &&
+            ms_game_status(loaded) == ms_game_status(c),
+        what);
+  ms_game_free(loaded);
+  ms_game_free(c);
+}
+
+int main() {
+  roundTrip(3, 3, 1, "fewest mines");
+  roundTrip(3, 3, 8, "most mines");
+  roundTrip(1, 2, 1, "smallest board");
+  roundTrip(4096, 4096, 1, "most cells");
+  roundTrip(256, 65535, 100, "widest board");
+
+  check(!Board::validSize(3, 3, 0), "no mines is invalid");
+  check(!Board::validSize(3, 3, 9), "no free cell is invalid");
+  check(!Board::validSize(4097, 4096, 1), "too many cells is invalid");
+  check(!Board::validSize(1, 65536, 1), "too many columns is invalid");
+  check(!ms_game_new(3, 3, 0, 0), "ms_game_new rejects no mines");
+
+  Board board(9, 9, 10);
+  check(board.inBounds(1, 1) && board.inBounds(9, 9), "corners in bounds");
+  check(!board.inBounds(0, 5) && !board.inBounds(5, 10), "border out of bounds");
+  ms_game* game = ms_game_new(9, 9, 10, 0);
+  check(ms_game_cell(game, 0, 1) == -1 && ms_game_cell(game, 1, 1) == 9,
+        "ms_game_cell bounds");
+  ms_game_free(game);
+
+  if (failures)
+    return 1;
+  printf("library: all checks passed\n");
+  return 0;
+}
@@ -0,0 +1,39 @@
+#include <stdio.h>
+#include <chrono>
+#include <thread>
+#include "../src/pregen.h"
+
+// Checks that pooled boards are handed out once.
+
+static int failures = 0;
+
+static void check(bool ok, const char* what) {
+  if (!ok) {
+    fprintf(stderr, "FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+// A no-guess game of the pooled size, opened at (r, c) once the generator has
+// had time to pool a seed for that cell.
+static uint64_t noGuessSeed(int r, int c) {
+  GameState state;
+  initBoard(state, 9, 9, 10);
+  state.noGuess = true;
+  prepareBoards(9, 9, 10, true);
+  aimBoards(state, r, c);
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  firstClickBoard(state, r, c);
+  return state.seed;
+}
+
+int main() {
+  uint64_t first = noGuessSeed(1, 1), second = noGuessSeed(1, 1);
+  check(first != second, "no-guess games at the same cell get new boards");
+  stopBoardPool();
+
+  if (failures)
+    return 1;
+  printf("pregen: all checks passed\n");
+  return 0;
+}